@@ -94,6 +94,11 @@ public:
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
+	/// Ray-cast a packet of rays against the proxies in the tree.
+	/// @see b2DynamicTree::RayCastPacket
+	template <typename T>
+	void RayCastPacket(T* callback, const b2RayCastInput* inputs, int32 count) const;
+
 	/// Get the height of the embedded tree.
 	int32 GetTreeHeight() const;
 
@@ -230,6 +235,12 @@ inline void b2BroadPhase::RayCast(T* callback, const b2RayCastInput& input) cons
 	m_tree.RayCast(callback, input);
 }
 
+template <typename T>
+inline void b2BroadPhase::RayCastPacket(T* callback, const b2RayCastInput* inputs, int32 count) const
+{
+	m_tree.RayCastPacket(callback, inputs, count);
+}
+
 inline void b2BroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	m_tree.ShiftOrigin(newOrigin);
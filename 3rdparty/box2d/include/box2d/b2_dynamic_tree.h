@@ -29,6 +29,9 @@
 
 #define b2_nullNode (-1)
 
+/// The maximum number of rays tested together by b2DynamicTree::RayCastPacket.
+#define b2_maxRayPacketSize 32
+
 /// A node in the dynamic tree. The client does not interact with this directly.
 struct B2_API b2TreeNode
 {
@@ -57,6 +60,33 @@ struct B2_API b2TreeNode
 	bool moved;
 };
 
+/// A bundle of rays stored as a structure of arrays, so that the rays can be tested
+/// against a node AABB together with SIMD slab tests. Bit i of a ray mask refers to ray i.
+struct B2_API b2RayPacket
+{
+	/// Set the rays from an array of ray-cast inputs.
+	void Set(const b2RayCastInput* inputs, int32 count);
+
+	/// Recompute the packet bounds from the rays in the mask.
+	void UpdateBounds(uint32 mask);
+
+	/// Get the subset of the rays in the mask whose segment overlaps the AABB.
+	uint32 TestOverlap(const b2AABB& aabb, uint32 mask) const;
+
+	float px[b2_maxRayPacketSize];
+	float py[b2_maxRayPacketSize];
+	float dx[b2_maxRayPacketSize];
+	float dy[b2_maxRayPacketSize];
+	float invDx[b2_maxRayPacketSize];
+	float invDy[b2_maxRayPacketSize];
+	float maxFraction[b2_maxRayPacketSize];
+
+	/// Bounds of all the active ray segments.
+	b2AABB bounds;
+
+	int32 count;
+};
+
 /// A dynamic AABB tree broad-phase, inspired by Nathanael Presson's btDbvt.
 /// A dynamic tree arranges data in a binary tree to accelerate
 /// queries such as volume queries and ray casts. Leafs are proxies
@@ -111,6 +141,15 @@ public:
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
+	/// Ray-cast a packet of rays against the proxies in the tree. The rays are tested together
+	/// against each node, so coherent rays, like the rays of a range scanner, share the node
+	/// visits near the root. The callback is called as RayCastCallback(input, proxyId, rayIndex)
+	/// and returns the new max fraction of that ray, with the same meaning as for RayCast.
+	/// @param inputs the ray-cast input data, one per ray.
+	/// @param count the number of rays, at most b2_maxRayPacketSize.
+	template <typename T>
+	void RayCastPacket(T* callback, const b2RayCastInput* inputs, int32 count) const;
+
 	/// Validate this tree. For testing.
 	void Validate() const;
 
@@ -305,4 +344,103 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 	}
 }
 
+template <typename T>
+inline void b2DynamicTree::RayCastPacket(T* callback, const b2RayCastInput* inputs, int32 count) const
+{
+	b2Assert(0 < count && count <= b2_maxRayPacketSize);
+
+	b2RayPacket packet;
+	packet.Set(inputs, count);
+
+	const uint32 allRays = count == 32 ? 0xFFFFFFFFu : (1u << count) - 1u;
+	uint32 liveRays = allRays;
+
+	struct StackEntry
+	{
+		int32 nodeId;
+		uint32 mask;
+	};
+
+	b2GrowableStack<StackEntry, 256> stack;
+	stack.Push({m_root, allRays});
+
+	while (stack.GetCount() > 0)
+	{
+		StackEntry entry = stack.Pop();
+		if (entry.nodeId == b2_nullNode)
+		{
+			continue;
+		}
+
+		// Drop the rays terminated since this node was pushed.
+		uint32 mask = entry.mask & liveRays;
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		const b2TreeNode* node = m_nodes + entry.nodeId;
+
+		// Cull the whole packet before testing the individual rays.
+		if (b2TestOverlap(node->aabb, packet.bounds) == false)
+		{
+			continue;
+		}
+
+		mask = packet.TestOverlap(node->aabb, mask);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		if (node->IsLeaf())
+		{
+			bool clipped = false;
+
+			while (mask != 0)
+			{
+				int32 i = 0;
+				while ((mask & (1u << i)) == 0)
+				{
+					++i;
+				}
+				mask &= ~(1u << i);
+
+				b2RayCastInput subInput;
+				subInput.p1 = inputs[i].p1;
+				subInput.p2 = inputs[i].p2;
+				subInput.maxFraction = packet.maxFraction[i];
+
+				float value = callback->RayCastCallback(subInput, entry.nodeId, i);
+
+				if (value == 0.0f)
+				{
+					// The client has terminated this ray.
+					liveRays &= ~(1u << i);
+					if (liveRays == 0)
+					{
+						return;
+					}
+					clipped = true;
+				}
+				else if (value > 0.0f)
+				{
+					packet.maxFraction[i] = value;
+					clipped = true;
+				}
+			}
+
+			if (clipped)
+			{
+				packet.UpdateBounds(liveRays);
+			}
+		}
+		else
+		{
+			stack.Push({node->child1, mask});
+			stack.Push({node->child2, mask});
+		}
+	}
+}
+
 #endif
@@ -96,6 +96,14 @@ struct B2_API b2JointUserData
 B2_API void* b2Alloc_Default(int32 size);
 B2_API void b2Free_Default(void* mem);
 
+/// Allocation hooks used by the default allocation functions
+typedef void* b2AllocFcn(int32 size, void* context);
+typedef void b2FreeFcn(void* mem, void* context);
+
+/// Route the default allocation functions to your own allocator, or back to malloc/free with null functions.
+/// Memory must be freed by the same allocator that allocated it, so set this before creating any world.
+B2_API void b2SetAllocator(b2AllocFcn* allocFcn, b2FreeFcn* freeFcn, void* context);
+
 /// Implement this function to use your own memory allocator.
 inline void* b2Alloc(int32 size)
 {
@@ -126,6 +126,15 @@ public:
 	/// @param point2 the ray ending point
 	void RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2) const;
 
+	/// Ray-cast the world for a fan of rays sharing a starting point, such as the rays of a range
+	/// scanner. The rays are traversed through the broad-phase in packets, which visits far fewer
+	/// tree nodes than casting them one by one. Each ray reports to its own callback.
+	/// @param callbacks one user implemented callback per ray.
+	/// @param point1 the starting point of all rays
+	/// @param points2 the ending point of each ray
+	/// @param count the number of rays
+	void RayCastPacket(b2RayCastCallback* const* callbacks, const b2Vec2& point1, const b2Vec2* points2, int32 count) const;
+
 	/// Get the world body list. With the returned body, use b2Body::GetNext to get
 	/// the next body in the world list. A nullptr body indicates the end of the list.
 	/// @return the head of the world body list.
@@ -22,6 +22,125 @@
 #include "box2d/b2_dynamic_tree.h"
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define B2_RAY_PACKET_SSE2
+#include <emmintrin.h>
+#endif
+
+void b2RayPacket::Set(const b2RayCastInput* inputs, int32 n)
+{
+	b2Assert(0 < n && n <= b2_maxRayPacketSize);
+	count = n;
+
+	for (int32 i = 0; i < b2_maxRayPacketSize; ++i)
+	{
+		// Unused lanes repeat the first ray so the slab tests never read garbage.
+		const b2RayCastInput& input = inputs[i < n ? i : 0];
+		b2Vec2 d = input.p2 - input.p1;
+
+		px[i] = input.p1.x;
+		py[i] = input.p1.y;
+		dx[i] = d.x;
+		dy[i] = d.y;
+
+		// A huge inverse stands in for infinity. Unlike infinity, 0 * b2_maxFloat is not NaN.
+		invDx[i] = b2Abs(d.x) > b2_epsilon ? 1.0f / d.x : (d.x < 0.0f ? -b2_maxFloat : b2_maxFloat);
+		invDy[i] = b2Abs(d.y) > b2_epsilon ? 1.0f / d.y : (d.y < 0.0f ? -b2_maxFloat : b2_maxFloat);
+
+		maxFraction[i] = input.maxFraction;
+	}
+
+	UpdateBounds(n == 32 ? 0xFFFFFFFFu : (1u << n) - 1u);
+}
+
+void b2RayPacket::UpdateBounds(uint32 mask)
+{
+	bounds.lowerBound.Set(b2_maxFloat, b2_maxFloat);
+	bounds.upperBound.Set(-b2_maxFloat, -b2_maxFloat);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		if ((mask & (1u << i)) == 0)
+		{
+			continue;
+		}
+
+		b2Vec2 p1(px[i], py[i]);
+		b2Vec2 t(px[i] + maxFraction[i] * dx[i], py[i] + maxFraction[i] * dy[i]);
+		bounds.lowerBound = b2Min(bounds.lowerBound, b2Min(p1, t));
+		bounds.upperBound = b2Max(bounds.upperBound, b2Max(p1, t));
+	}
+}
+
+uint32 b2RayPacket::TestOverlap(const b2AABB& aabb, uint32 mask) const
+{
+	uint32 result = 0;
+
+	// Slab test: clip each segment [0, maxFraction] against the x and y slabs of the AABB.
+#if defined(B2_RAY_PACKET_SSE2)
+	const __m128 lowerX = _mm_set1_ps(aabb.lowerBound.x);
+	const __m128 lowerY = _mm_set1_ps(aabb.lowerBound.y);
+	const __m128 upperX = _mm_set1_ps(aabb.upperBound.x);
+	const __m128 upperY = _mm_set1_ps(aabb.upperBound.y);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (int32 base = 0; base < count; base += 4)
+	{
+		uint32 remaining = mask >> base;
+		if (remaining == 0)
+		{
+			break;
+		}
+
+		uint32 lanes = remaining & 0xFu;
+		if (lanes == 0)
+		{
+			continue;
+		}
+
+		__m128 x = _mm_loadu_ps(px + base);
+		__m128 y = _mm_loadu_ps(py + base);
+		__m128 ix = _mm_loadu_ps(invDx + base);
+		__m128 iy = _mm_loadu_ps(invDy + base);
+
+		__m128 tx1 = _mm_mul_ps(_mm_sub_ps(lowerX, x), ix);
+		__m128 tx2 = _mm_mul_ps(_mm_sub_ps(upperX, x), ix);
+		__m128 ty1 = _mm_mul_ps(_mm_sub_ps(lowerY, y), iy);
+		__m128 ty2 = _mm_mul_ps(_mm_sub_ps(upperY, y), iy);
+
+		__m128 tmin = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2)), zero);
+		__m128 tmax = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2)),
+								 _mm_loadu_ps(maxFraction + base));
+
+		uint32 hit = (uint32)_mm_movemask_ps(_mm_cmple_ps(tmin, tmax));
+		result |= (hit & lanes) << base;
+	}
+#else
+	for (int32 i = 0; i < count; ++i)
+	{
+		if ((mask & (1u << i)) == 0)
+		{
+			continue;
+		}
+
+		float tx1 = (aabb.lowerBound.x - px[i]) * invDx[i];
+		float tx2 = (aabb.upperBound.x - px[i]) * invDx[i];
+		float ty1 = (aabb.lowerBound.y - py[i]) * invDy[i];
+		float ty2 = (aabb.upperBound.y - py[i]) * invDy[i];
+
+		float tmin = b2Max(b2Max(b2Min(tx1, tx2), b2Min(ty1, ty2)), 0.0f);
+		float tmax = b2Min(b2Min(b2Max(tx1, tx2), b2Max(ty1, ty2)), maxFraction[i]);
+
+		if (tmin <= tmax)
+		{
+			result |= 1u << i;
+		}
+	}
+#endif
+
+	return result;
+}
+
 b2DynamicTree::b2DynamicTree()
 {
 	m_root = b2_nullNode;
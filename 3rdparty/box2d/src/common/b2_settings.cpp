@@ -29,14 +29,36 @@
 
 b2Version b2_version = {2, 4, 1};
 
+static b2AllocFcn* b2_allocFcn = nullptr;
+static b2FreeFcn* b2_freeFcn = nullptr;
+static void* b2_allocContext = nullptr;
+
+void b2SetAllocator(b2AllocFcn* allocFcn, b2FreeFcn* freeFcn, void* context)
+{
+	b2_allocFcn = allocFcn;
+	b2_freeFcn = freeFcn;
+	b2_allocContext = context;
+}
+
 // Memory allocators. Modify these to use your own allocator.
 void* b2Alloc_Default(int32 size)
 {
+	if (b2_allocFcn)
+	{
+		return b2_allocFcn(size, b2_allocContext);
+	}
+
 	return malloc(size);
 }
 
 void b2Free_Default(void* mem)
 {
+	if (b2_freeFcn)
+	{
+		b2_freeFcn(mem, b2_allocContext);
+		return;
+	}
+
 	free(mem);
 }
 
@@ -1036,6 +1036,53 @@ void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b
 	m_contactManager.m_broadPhase.RayCast(&wrapper, input);
 }
 
+struct b2WorldRayCastPacketWrapper
+{
+	float RayCastCallback(const b2RayCastInput& input, int32 proxyId, int32 rayIndex)
+	{
+		void* userData = broadPhase->GetUserData(proxyId);
+		b2FixtureProxy* proxy = (b2FixtureProxy*)userData;
+		b2Fixture* fixture = proxy->fixture;
+		int32 index = proxy->childIndex;
+		b2RayCastOutput output;
+		bool hit = fixture->RayCast(&output, input, index);
+
+		if (hit)
+		{
+			float fraction = output.fraction;
+			b2Vec2 point = (1.0f - fraction) * input.p1 + fraction * input.p2;
+			return callbacks[rayIndex]->ReportFixture(fixture, point, output.normal, fraction);
+		}
+
+		return input.maxFraction;
+	}
+
+	const b2BroadPhase* broadPhase;
+	b2RayCastCallback* const* callbacks;
+};
+
+void b2World::RayCastPacket(b2RayCastCallback* const* callbacks, const b2Vec2& point1, const b2Vec2* points2, int32 count) const
+{
+	b2WorldRayCastPacketWrapper wrapper;
+	wrapper.broadPhase = &m_contactManager.m_broadPhase;
+
+	b2RayCastInput inputs[b2_maxRayPacketSize];
+
+	for (int32 first = 0; first < count; first += b2_maxRayPacketSize)
+	{
+		int32 packetCount = b2Min(count - first, b2_maxRayPacketSize);
+		for (int32 i = 0; i < packetCount; ++i)
+		{
+			inputs[i].maxFraction = 1.0f;
+			inputs[i].p1 = point1;
+			inputs[i].p2 = points2[first + i];
+		}
+
+		wrapper.callbacks = callbacks + first;
+		m_contactManager.m_broadPhase.RayCastPacket(&wrapper, inputs, packetCount);
+	}
+}
+
 void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
 {
 	switch (fixture->GetType())
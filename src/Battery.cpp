@@ -71,9 +71,9 @@ Battery::getOCV(double n)
     return v_max * pow(getSoC(), 1/n) + v_min * (1 - pow(getSoC(), 1/n));
 }
 int
-Battery::BatUpdate(double I)
+Battery::BatUpdate(double I, double T)
 {
-    //I is positive when supplying energy to robot, negative when charging
+    //I is positive when supplying energy to robot, negative when charging, T is the simulated time in seconds
     double SOC_0, SOC;
     SOC_0 = getSoC();
     current_tick_drain += I;
@@ -81,18 +81,19 @@ Battery::BatUpdate(double I)
     //this section is still being fixed, but it is 40-60% accurate atm
     /////////////////////////////////////////////////////////////////////////
     //[1 min, 1 hr, 60 hrs] in sim per second is [3600, 60, 1] value to be multiplied by cap_
-    //NOTE: THIS FUNCTION IS ONLY INTENDED TO WORK AT 60 Hz, TIME FACTOR WILL CHANGE IF NOT UPDATED AT 60Hz
+    //NOTE: tuned at 60 Hz, the drain per update is scaled by T relative to a 1/60 s step
+    const double steps = T * 60.0;
     if (SOC_0 >= 0.8 && SOC_0 <= 100){
-        SOC = SOC_0 - (I*(0.2*CRate_)/ (cap_ * 3600));
+        SOC = SOC_0 - (I*steps*(0.2*CRate_)/ (cap_ * 3600));
 
 
     }else{
     if (SOC_0 <= 0.2){
-        SOC = SOC_0 - (I*(2*CRate_)/ (cap_ * 3600));
+        SOC = SOC_0 - (I*steps*(2*CRate_)/ (cap_ * 3600));
 
     }
     else{
-        SOC = SOC_0 - (I*CRate_ /(cap_ * 3600 ));
+        SOC = SOC_0 - (I*steps*CRate_ /(cap_ * 3600 ));
 
     }}
     /////////////////////////////////////////////////////////////////////////
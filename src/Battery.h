@@ -44,7 +44,7 @@ public:
     float getOCVTable(double soc);
 
     double getOCV(double n);
-    int BatUpdate(double I);
+    int BatUpdate(double I, double T);
     void reset_current_tick_drain();
     float GetCurrentTick();
 
@@ -50,15 +50,18 @@ Alien::Alien(Simulation *simulation, Terrain *terrain, b2Vec2 pos, float rotatio
     fixdef.friction = 0.5;
     fixdef.restitution = 0.4;
     fixdef.userData.pointer = reinterpret_cast<uintptr_t>(this);
+    fixdef.filter.categoryBits = CollisionCategory::Alien;
     b2PolygonShape shape;
     shape.SetAsBox(1.f, 0.5f);
     fixdef.shape = &shape;
     body->CreateFixture(&fixdef);
 
-    sights_sensor = new ProximitySensor{simulation, pos, sight_distance, true, false};
+    sights_sensor = new ProximitySensor{simulation, pos, sight_distance, true, false, true};
+    sights_sensor->setDetectedCategories(CollisionCategory::Robot);
     simulation->SimulateObjectNextFrame(sights_sensor);
 
     name = "Alien";
+    type = ObjectType::Alien;
 
     FindNewMoveToTarget();
 }
@@ -67,14 +70,13 @@ void
 Alien::update()
 {
     sights_sensor->setPosition(getPosition(), 0.f);
-    sights_sensor->body->SetAwake(true); // Since we manually move the sensor, we need to wake it up all the time.
 
     g_debugDraw.DrawSolidCircle(getPosition(), sight_distance, {}, b2Color{1.f, 0.2f, 0.2f, 1.f});
 
     if (state == AlienState::WALK_AROUND) {
         WalkAround();
         for (auto &&object : sights_sensor->getObjectsInside()) {
-            if (auto robot = dynamic_cast<Robot *>(object)) {
+            if (object->type == ObjectType::Robot) {
                 state = AlienState::CHASE;
                 sight_distance = 30.f;
                 sights_sensor->setRadius(sight_distance);
@@ -84,8 +86,8 @@ Alien::update()
     } else if (state == AlienState::CHASE) {
         bool foundRobot = false;
         for (auto &&object : sights_sensor->getObjectsInside()) {
-            if (auto robot = dynamic_cast<Robot *>(object)) {
-                auto dir = robot->getPosition() - getPosition();
+            if (object->type == ObjectType::Robot) {
+                auto dir = object->getPosition() - getPosition();
                 dir.Normalize();
                 dir.x *= 125.f;
                 dir.y *= 125.f;
@@ -119,7 +121,7 @@ Alien::WalkAround()
 
     addForce(dir);
 
-    if (simulation->GetStepCount() % 1200 == 0) {
+    if (simulation->IsIntervalDue(20.0)) {
         FindNewMoveToTarget();
     }
 }
@@ -0,0 +1,206 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "arena.h"
+
+#include "box2d/b2_settings.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+void *
+box2dAlloc(int32 size, void *)
+{
+    return Arena::allocateActive(static_cast<size_t>(size));
+}
+
+void
+box2dFree(void *mem, void *)
+{
+    Arena::release(mem);
+}
+
+} // namespace
+
+Arena::Arena()
+{
+    // Installed once and kept, so memory Box2D allocated through one arena can always be freed, even after the next
+    // arena became active. Every allocation records its owner.
+    static bool hooksInstalled = false;
+    if (!hooksInstalled) {
+        b2SetAllocator(box2dAlloc, box2dFree, nullptr);
+        hooksInstalled = true;
+    }
+
+    active = this;
+}
+
+Arena::~Arena()
+{
+    for (auto &&page : pages) {
+        std::free(page);
+    }
+
+    while (largeBlocks) {
+        auto next = largeBlocks->next;
+        std::free(largeBlocks);
+        largeBlocks = next;
+    }
+
+    if (active == this) {
+        active = nullptr;
+    }
+}
+
+void *
+Arena::allocate(size_t size)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    stats.allocations++;
+    stats.bytesInUse += size;
+
+    size_t blockSize = sizeof(Header) + size;
+    uint32_t sizeClass = 0;
+    while (sizeClass < sizeClassCount && (size_t{1} << (sizeClass + minBlockShift)) < blockSize) {
+        sizeClass++;
+    }
+
+    Header *header;
+    if (sizeClass == largeSizeClass) {
+        auto block = static_cast<LargeBlock *>(std::malloc(sizeof(LargeBlock) + blockSize));
+        if (!block) {
+            throw std::bad_alloc{};
+        }
+        block->prev = nullptr;
+        block->next = largeBlocks;
+        if (largeBlocks) {
+            largeBlocks->prev = block;
+        }
+        largeBlocks = block;
+        stats.bytesReserved += sizeof(LargeBlock) + blockSize;
+
+        header = reinterpret_cast<Header *>(block + 1);
+    } else if (freeLists[sizeClass]) {
+        // Free blocks keep the next free block where the payload was
+        header = freeLists[sizeClass];
+        freeLists[sizeClass] = *reinterpret_cast<Header **>(header + 1);
+    } else {
+        blockSize = size_t{1} << (sizeClass + minBlockShift);
+        if (pageCursor + blockSize > pageEnd) {
+            pageCursor = static_cast<char *>(std::malloc(pageSize));
+            if (!pageCursor) {
+                throw std::bad_alloc{};
+            }
+            pageEnd = pageCursor + pageSize;
+            pages.push_back(pageCursor);
+            stats.bytesReserved += pageSize;
+        }
+        header = reinterpret_cast<Header *>(pageCursor);
+        pageCursor += blockSize;
+    }
+
+    header->owner = this;
+    header->sizeClass = sizeClass;
+    header->size = static_cast<uint32_t>(size);
+    return header + 1;
+}
+
+void
+Arena::deallocate(Header *header)
+{
+    // Large blocks stay in their list, which the destructor frees
+    if (tearingDown) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    stats.frees++;
+    stats.bytesInUse -= header->size;
+
+    if (header->sizeClass == largeSizeClass) {
+        auto block = reinterpret_cast<LargeBlock *>(header) - 1;
+        if (block->prev) {
+            block->prev->next = block->next;
+        } else {
+            largeBlocks = block->next;
+        }
+        if (block->next) {
+            block->next->prev = block->prev;
+        }
+        stats.bytesReserved -= sizeof(LargeBlock) + sizeof(Header) + header->size;
+        std::free(block);
+        return;
+    }
+
+    *reinterpret_cast<Header **>(header + 1) = freeLists[header->sizeClass];
+    freeLists[header->sizeClass] = header;
+}
+
+Arena::Stats
+Arena::getStats()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return stats;
+}
+
+void
+Arena::beginTeardown()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    tearingDown = true;
+}
+
+void *
+Arena::allocateActive(size_t size)
+{
+    if (active) {
+        return active->allocate(size);
+    }
+
+    auto header = static_cast<Header *>(std::malloc(sizeof(Header) + size));
+    if (!header) {
+        throw std::bad_alloc{};
+    }
+    header->owner = nullptr;
+    header->sizeClass = largeSizeClass;
+    header->size = static_cast<uint32_t>(size);
+    return header + 1;
+}
+
+void
+Arena::release(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    auto header = static_cast<Header *>(ptr) - 1;
+    if (header->owner) {
+        header->owner->deallocate(header);
+    } else {
+        std::free(header);
+    }
+}
@@ -0,0 +1,106 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_ARENA_H
+#define MARSIM_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Pool allocator for everything a simulation allocates in bulk: its objects and the Box2D world. Blocks are carved out
+// of large pages into power of two size classes with a free list each, and all pages are released at once when the
+// arena is destroyed. The newest arena is the active one, which Object::operator new and b2Alloc allocate from.
+class Arena
+{
+public:
+    struct Stats
+    {
+        size_t allocations{0};
+        size_t frees{0};
+        size_t bytesInUse{0};    // requested by live allocations
+        size_t bytesReserved{0}; // held in pages and large blocks
+    };
+
+    Arena();
+
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t size);
+
+    Stats getStats();
+
+    // Called when everything allocated is about to be dropped with the arena. Frees after this are no-ops, since the
+    // pages are released whole anyway.
+    void beginTeardown();
+
+    // Allocates from the active arena, or the heap if there is none
+    static void *allocateActive(size_t size);
+
+    // Frees memory from allocate or allocateActive, whichever arena it came from
+    static void release(void *ptr);
+
+private:
+    // Placed in front of every allocation, keeps the payload 16 byte aligned
+    struct Header
+    {
+        Arena *owner;
+        uint32_t sizeClass;
+        uint32_t size;
+    };
+    static_assert(sizeof(Header) == 16, "The header must keep the payload 16 byte aligned");
+
+    // Placed in front of the header of allocations too large for a size class
+    struct LargeBlock
+    {
+        LargeBlock *prev;
+        LargeBlock *next;
+    };
+
+    static constexpr uint32_t minBlockShift = 5;  // 32 bytes
+    static constexpr uint32_t sizeClassCount = 12; // up to 64 KB
+    static constexpr uint32_t largeSizeClass = sizeClassCount;
+    static constexpr size_t pageSize = 256 * 1024;
+
+    void deallocate(Header *header);
+
+    std::mutex mutex;
+
+    std::vector<char *> pages;
+    char *pageCursor{nullptr};
+    char *pageEnd{nullptr};
+
+    Header *freeLists[sizeClassCount]{};
+    LargeBlock *largeBlocks{nullptr};
+
+    Stats stats;
+    bool tearingDown{false};
+
+    static inline Arena *active{nullptr};
+};
+
+#endif // MARSIM_ARENA_H
@@ -0,0 +1,842 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "command_parser.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+constexpr int maxDepth = 64;
+
+// What a member of the message is, the fields of data use their Command::Field bit
+constexpr uint32_t ignoredMember = 0;
+constexpr uint32_t typeMember = 1u << 30;
+constexpr uint32_t dataMember = 1u << 31;
+
+constexpr uint32_t
+hashName(std::string_view name)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+// Open addressing table from names to values, built at compile time. Size is a power of two, with room to spare.
+template <size_t Size>
+class NameTable
+{
+public:
+    struct Entry
+    {
+        std::string_view name;
+        uint32_t value;
+    };
+
+    constexpr NameTable(std::initializer_list<Entry> entries) : slots{}
+    {
+        for (const auto &entry : entries) {
+            size_t slot = hashName(entry.name) & (Size - 1);
+            while (!slots[slot].name.empty()) {
+                slot = (slot + 1) & (Size - 1);
+            }
+            slots[slot] = entry;
+        }
+    }
+
+    constexpr uint32_t
+    find(std::string_view name, uint32_t missing) const
+    {
+        size_t slot = hashName(name) & (Size - 1);
+        while (!slots[slot].name.empty()) {
+            if (slots[slot].name == name) {
+                return slots[slot].value;
+            }
+            slot = (slot + 1) & (Size - 1);
+        }
+        return missing;
+    }
+
+private:
+    Entry slots[Size];
+};
+
+constexpr NameTable<32> commandTypes{
+    {"motors", static_cast<uint32_t>(CommandType::Motors)},
+    {"pickup", static_cast<uint32_t>(CommandType::Pickup)},
+    {"drop", static_cast<uint32_t>(CommandType::Drop)},
+    {"shoot_laser", static_cast<uint32_t>(CommandType::ShootLaser)},
+    {"laser_angle", static_cast<uint32_t>(CommandType::LaserAngle)},
+    {"request_satellite_image", static_cast<uint32_t>(CommandType::RequestImage)},
+    {"request_satellite_image_blurred", static_cast<uint32_t>(CommandType::RequestImageBlurred)},
+    {"arm_speeds", static_cast<uint32_t>(CommandType::ArmSpeeds)},
+    {"arm_close", static_cast<uint32_t>(CommandType::ArmClose)},
+    {"arm_open", static_cast<uint32_t>(CommandType::ArmOpen)},
+    {"arm_fold_lock", static_cast<uint32_t>(CommandType::ArmFoldLock)},
+    {"arm_fold_unlock", static_cast<uint32_t>(CommandType::ArmFoldUnlock)},
+    {"robot_lock_base", static_cast<uint32_t>(CommandType::RobotLockBase)},
+    {"robot_unlock_base", static_cast<uint32_t>(CommandType::RobotUnlockBase)},
+};
+
+constexpr NameTable<16> dataFields{
+    {"left", Command::Left},
+    {"right", Command::Right},
+    {"speed1", Command::Speed1},
+    {"speed2", Command::Speed2},
+    {"speed3", Command::Speed3},
+    {"angle", Command::Angle},
+    {"id", Command::Id},
+    {"index", Command::Index},
+};
+
+uint64_t
+readBigEndian(const char *data, size_t width)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < width; i++) {
+        value = (value << 8) | static_cast<uint8_t>(data[i]);
+    }
+    return value;
+}
+
+void
+appendUtf8(char *buffer, size_t &length, size_t capacity, uint32_t codepoint)
+{
+    char encoded[3];
+    size_t count;
+    if (codepoint < 0x80) {
+        encoded[0] = static_cast<char>(codepoint);
+        count = 1;
+    } else if (codepoint < 0x800) {
+        encoded[0] = static_cast<char>(0xC0 | (codepoint >> 6));
+        encoded[1] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        count = 2;
+    } else {
+        encoded[0] = static_cast<char>(0xE0 | (codepoint >> 12));
+        encoded[1] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        encoded[2] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        count = 3;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (length < capacity) {
+            buffer[length] = encoded[i];
+        }
+        length++;
+    }
+}
+
+#if !defined(__cpp_lib_to_chars)
+// std::from_chars for double is missing on some standard libraries (Apple libc++), and strtod depends on the
+// locale. Exact when the significant digits fit in 53 bits and the power of ten is at most 22, which covers the
+// numbers commands carry, otherwise within a few ulp
+bool
+parseDecimal(const char *&position, const char *end, double &number)
+{
+    constexpr double powersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    constexpr int maxDigits = 19;
+
+    const char *p = position;
+    const auto isDigit = [&p, end]() { return p != end && *p >= '0' && *p <= '9'; };
+
+    bool negative = p != end && *p == '-';
+    if (negative) {
+        ++p;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    for (; isDigit(); ++p) {
+        hasDigits = true;
+        if (digits < maxDigits) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            digits += mantissa != 0;
+        } else {
+            exponent++;
+        }
+    }
+    if (!hasDigits) {
+        return false;
+    }
+    if (p != end && *p == '.') {
+        ++p;
+        if (!isDigit()) {
+            return false;
+        }
+        for (; isDigit(); ++p) {
+            if (digits < maxDigits) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = false;
+        if (p != end && (*p == '+' || *p == '-')) {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+        if (!isDigit()) {
+            return false;
+        }
+        int value = 0;
+        for (; isDigit(); ++p) {
+            if (value < 10000) {
+                value = value * 10 + (*p - '0');
+            }
+        }
+        exponent += negativeExponent ? -value : value;
+    }
+
+    double value = static_cast<double>(mantissa);
+    if (mantissa != 0) {
+        if (mantissa <= (uint64_t{1} << 53) && exponent >= -22 && exponent <= 22) {
+            value = exponent < 0 ? value / powersOfTen[-exponent] : value * powersOfTen[exponent];
+        } else {
+            value *= std::pow(10.0, exponent);
+        }
+        if (!std::isfinite(value) || value == 0.0) {
+            return false;
+        }
+    }
+    number = negative ? -value : value;
+    position = p;
+    return true;
+}
+#endif
+
+} // namespace
+
+bool
+CommandParser::parse(const char *data, size_t size, bool messagePack, Command &command)
+{
+    position = data;
+    end = data + size;
+    errorMessage = "";
+    hasType = false;
+    command = Command{};
+
+    if (!(messagePack ? parseMessagePack(command) : parseJson(command))) {
+        return false;
+    }
+    if (!hasType) {
+        return fail("the message has no type");
+    }
+    return true;
+}
+
+const char *
+CommandParser::error() const
+{
+    return errorMessage;
+}
+
+CommandType
+CommandParser::lookupType(std::string_view type)
+{
+    return static_cast<CommandType>(commandTypes.find(type, static_cast<uint32_t>(CommandType::Unknown)));
+}
+
+uint32_t
+CommandParser::lookupMember(std::string_view key, int depth)
+{
+    if (depth == 1) {
+        if (key == "type") {
+            return typeMember;
+        }
+        if (key == "data") {
+            return dataMember;
+        }
+        return ignoredMember;
+    }
+    return dataFields.find(key, ignoredMember);
+}
+
+bool
+CommandParser::storeMember(Command &command, uint32_t member, const Token &token)
+{
+    if (member == typeMember) {
+        if (token.kind != Token::String) {
+            return false;
+        }
+        command.type = lookupType(token.string);
+        hasType = true;
+        return true;
+    }
+
+    if (member == ignoredMember || member == dataMember || token.kind != Token::Number) {
+        return false;
+    }
+
+    const double number = token.number;
+    switch (member) {
+    case Command::Left:
+        command.left = static_cast<float>(number);
+        break;
+    case Command::Right:
+        command.right = static_cast<float>(number);
+        break;
+    case Command::Speed1:
+        command.speed1 = static_cast<float>(number);
+        break;
+    case Command::Speed2:
+        command.speed2 = static_cast<float>(number);
+        break;
+    case Command::Speed3:
+        command.speed3 = static_cast<float>(number);
+        break;
+    case Command::Angle:
+        command.angle = static_cast<float>(number);
+        break;
+    case Command::Id:
+        command.id = static_cast<unsigned int>(static_cast<int64_t>(number));
+        break;
+    case Command::Index:
+        command.index = static_cast<unsigned int>(static_cast<int64_t>(number));
+        break;
+    default:
+        return false;
+    }
+    command.fields |= member;
+    return true;
+}
+
+bool
+CommandParser::fail(const char *message)
+{
+    errorMessage = message;
+    return false;
+}
+
+bool
+CommandParser::parseJson(Command &command)
+{
+    skipWhitespace();
+    if (position == end || *position != '{') {
+        return fail("the message is not an object");
+    }
+    ++position;
+
+    if (!parseJsonObject(command, 1)) {
+        return false;
+    }
+
+    skipWhitespace();
+    if (position != end) {
+        return fail("unexpected characters after the message");
+    }
+    return true;
+}
+
+bool
+CommandParser::parseJsonObject(Command &command, int depth)
+{
+    skipWhitespace();
+    if (position != end && *position == '}') {
+        ++position;
+        return true;
+    }
+
+    while (true) {
+        skipWhitespace();
+        std::string_view key;
+        if (!readJsonString(key)) {
+            return false;
+        }
+        const uint32_t member = lookupMember(key, depth);
+
+        skipWhitespace();
+        if (position == end || *position != ':') {
+            return fail("expected a colon after a key");
+        }
+        ++position;
+
+        Token token;
+        if (!readJsonToken(token)) {
+            return false;
+        }
+        if (member == typeMember && token.kind != Token::String) {
+            return fail("the type is not a string");
+        }
+        if (member == dataMember && token.kind == Token::Object) {
+            if (!parseJsonObject(command, depth + 1)) {
+                return false;
+            }
+        } else if (!storeMember(command, member, token) && !skipJsonValue(token, depth + 1)) {
+            return false;
+        }
+
+        skipWhitespace();
+        if (position == end) {
+            return fail("unterminated object");
+        }
+        if (*position == ',') {
+            ++position;
+        } else if (*position == '}') {
+            ++position;
+            return true;
+        } else {
+            return fail("expected a comma or a closing brace");
+        }
+    }
+}
+
+void
+CommandParser::skipWhitespace()
+{
+    while (position != end && (*position == ' ' || *position == '\t' || *position == '\n' || *position == '\r')) {
+        ++position;
+    }
+}
+
+bool
+CommandParser::readJsonToken(Token &token)
+{
+    skipWhitespace();
+    if (position == end) {
+        return fail("unexpected end of the message");
+    }
+
+    const char c = *position;
+    if (c == '{') {
+        ++position;
+        token.kind = Token::Object;
+        return true;
+    }
+    if (c == '[') {
+        ++position;
+        token.kind = Token::Array;
+        return true;
+    }
+    if (c == '"') {
+        token.kind = Token::String;
+        return readJsonString(token.string);
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        if (c == '-' && (position + 1 == end || position[1] < '0' || position[1] > '9')) {
+            return fail("invalid number");
+        }
+#if defined(__cpp_lib_to_chars)
+        auto result = std::from_chars(position, end, token.number);
+        if (result.ec != std::errc{}) {
+            return fail("invalid number");
+        }
+        position = result.ptr;
+#else
+        if (!parseDecimal(position, end, token.number)) {
+            return fail("invalid number");
+        }
+#endif
+        token.kind = Token::Number;
+        return true;
+    }
+
+    const auto literal = [this](const char *text, size_t length) {
+        if (static_cast<size_t>(end - position) < length || std::memcmp(position, text, length) != 0) {
+            return false;
+        }
+        position += length;
+        return true;
+    };
+    if (literal("true", 4) || literal("false", 5)) {
+        token.kind = Token::Boolean;
+        return true;
+    }
+    if (literal("null", 4)) {
+        token.kind = Token::Null;
+        return true;
+    }
+    return fail("unexpected character");
+}
+
+bool
+CommandParser::readJsonString(std::string_view &string)
+{
+    if (position == end || *position != '"') {
+        return fail("expected a string");
+    }
+    const char *begin = ++position;
+
+    // Most strings have no escapes and are used where they are
+    while (position != end && *position != '"' && *position != '\\') {
+        ++position;
+    }
+    if (position == end) {
+        return fail("unterminated string");
+    }
+    if (*position == '"') {
+        string = std::string_view{begin, static_cast<size_t>(position - begin)};
+        ++position;
+        return true;
+    }
+
+    size_t length = position - begin;
+    std::memcpy(unescaped, begin, length < sizeof(unescaped) ? length : sizeof(unescaped));
+
+    while (position != end && *position != '"') {
+        char c = *position++;
+        if (c == '\\') {
+            if (position == end) {
+                break;
+            }
+            c = *position++;
+            switch (c) {
+            case 'b':
+                c = '\b';
+                break;
+            case 'f':
+                c = '\f';
+                break;
+            case 'n':
+                c = '\n';
+                break;
+            case 'r':
+                c = '\r';
+                break;
+            case 't':
+                c = '\t';
+                break;
+            case 'u': {
+                uint32_t codepoint = 0;
+                if (end - position < 4) {
+                    return fail("invalid escape in string");
+                }
+                for (int i = 0; i < 4; i++) {
+                    const char digit = *position++;
+                    codepoint <<= 4;
+                    if (digit >= '0' && digit <= '9') {
+                        codepoint |= digit - '0';
+                    } else if (digit >= 'a' && digit <= 'f') {
+                        codepoint |= digit - 'a' + 10;
+                    } else if (digit >= 'A' && digit <= 'F') {
+                        codepoint |= digit - 'A' + 10;
+                    } else {
+                        return fail("invalid escape in string");
+                    }
+                }
+                appendUtf8(unescaped, length, sizeof(unescaped), codepoint);
+                continue;
+            }
+            case '"':
+            case '\\':
+            case '/':
+                break;
+            default:
+                return fail("invalid escape in string");
+            }
+        }
+        if (length < sizeof(unescaped)) {
+            unescaped[length] = c;
+        }
+        length++;
+    }
+    if (position == end) {
+        return fail("unterminated string");
+    }
+    ++position;
+
+    // Too long for any known name, an empty string matches none either
+    string = length <= sizeof(unescaped) ? std::string_view{unescaped, length} : std::string_view{};
+    return true;
+}
+
+bool
+CommandParser::skipJsonValue(const Token &token, int depth)
+{
+    if (token.kind != Token::Object && token.kind != Token::Array) {
+        return true;
+    }
+    if (depth > maxDepth) {
+        return fail("the message is nested too deeply");
+    }
+
+    const bool object = token.kind == Token::Object;
+    const char close = object ? '}' : ']';
+
+    skipWhitespace();
+    if (position != end && *position == close) {
+        ++position;
+        return true;
+    }
+
+    while (true) {
+        if (object) {
+            skipWhitespace();
+            std::string_view key;
+            if (!readJsonString(key)) {
+                return false;
+            }
+            skipWhitespace();
+            if (position == end || *position != ':') {
+                return fail("expected a colon after a key");
+            }
+            ++position;
+        }
+
+        Token element;
+        if (!readJsonToken(element) || !skipJsonValue(element, depth + 1)) {
+            return false;
+        }
+
+        skipWhitespace();
+        if (position == end) {
+            return fail("unterminated object or array");
+        }
+        if (*position == ',') {
+            ++position;
+        } else if (*position == close) {
+            ++position;
+            return true;
+        } else {
+            return fail("expected a comma or a closing bracket");
+        }
+    }
+}
+
+bool
+CommandParser::parseMessagePack(Command &command)
+{
+    Token token;
+    if (!readMessagePackToken(token)) {
+        return false;
+    }
+    if (token.kind != Token::Object) {
+        return fail("the message is not a map");
+    }
+    if (!parseMessagePackObject(command, token.size, 1)) {
+        return false;
+    }
+    if (position != end) {
+        return fail("unexpected bytes after the message");
+    }
+    return true;
+}
+
+bool
+CommandParser::parseMessagePackObject(Command &command, uint32_t members, int depth)
+{
+    for (uint32_t i = 0; i < members; i++) {
+        Token key;
+        if (!readMessagePackToken(key)) {
+            return false;
+        }
+        if (key.kind != Token::String) {
+            return fail("a key is not a string");
+        }
+        const uint32_t member = lookupMember(key.string, depth);
+
+        Token token;
+        if (!readMessagePackToken(token)) {
+            return false;
+        }
+        if (member == typeMember && token.kind != Token::String) {
+            return fail("the type is not a string");
+        }
+        if (member == dataMember && token.kind == Token::Object) {
+            if (!parseMessagePackObject(command, token.size, depth + 1)) {
+                return false;
+            }
+        } else if (!storeMember(command, member, token) && !skipMessagePackValue(token, depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+CommandParser::readMessagePackToken(Token &token)
+{
+    if (position == end) {
+        return fail("unexpected end of the message");
+    }
+    const auto type = static_cast<uint8_t>(*position++);
+    const size_t available = end - position;
+
+    // Reads the big endian length or number following the type byte
+    const auto next = [&](size_t width) {
+        const uint64_t value = readBigEndian(position, width);
+        position += width;
+        return value;
+    };
+    const auto payload = [&](uint32_t bytes) {
+        if (static_cast<size_t>(end - position) < bytes) {
+            return fail("unexpected end of the message");
+        }
+        token.string = std::string_view{position, bytes};
+        position += bytes;
+        return true;
+    };
+
+    if (type <= 0x7F) {
+        token.kind = Token::Number;
+        token.number = type;
+        return true;
+    }
+    if (type >= 0xE0) {
+        token.kind = Token::Number;
+        token.number = static_cast<int8_t>(type);
+        return true;
+    }
+    if (type >= 0x80 && type <= 0x8F) {
+        token.kind = Token::Object;
+        token.size = type & 0x0F;
+        return true;
+    }
+    if (type >= 0x90 && type <= 0x9F) {
+        token.kind = Token::Array;
+        token.size = type & 0x0F;
+        return true;
+    }
+    if (type >= 0xA0 && type <= 0xBF) {
+        token.kind = Token::String;
+        return payload(type & 0x1F);
+    }
+
+    // Width of the value or length that follows
+    static constexpr uint8_t widths[] = {
+        0, 0, 0, 0,     // 0xC0 nil, 0xC1 unused, 0xC2 false, 0xC3 true
+        1, 2, 4,        // 0xC4-0xC6 bin
+        1, 2, 4,        // 0xC7-0xC9 ext, the ext type byte is skipped with the data
+        4, 8,           // 0xCA-0xCB float
+        1, 2, 4, 8,     // 0xCC-0xCF uint
+        1, 2, 4, 8,     // 0xD0-0xD3 int
+        0, 0, 0, 0, 0,  // 0xD4-0xD8 fixext, read as data below
+        1, 2, 4,        // 0xD9-0xDB str
+        2, 4,           // 0xDC-0xDD array
+        2, 4            // 0xDE-0xDF map
+    };
+    const size_t width = widths[type - 0xC0];
+    if (available < width) {
+        return fail("unexpected end of the message");
+    }
+
+    switch (type) {
+    case 0xC0:
+        token.kind = Token::Null;
+        return true;
+    case 0xC2:
+    case 0xC3:
+        token.kind = Token::Boolean;
+        return true;
+    case 0xC4:
+    case 0xC5:
+    case 0xC6:
+        token.kind = Token::Other;
+        return payload(static_cast<uint32_t>(next(width)));
+    case 0xC7:
+    case 0xC8:
+    case 0xC9:
+        token.kind = Token::Other;
+        return payload(static_cast<uint32_t>(next(width)) + 1);
+    case 0xCA: {
+        const auto bits = static_cast<uint32_t>(next(width));
+        float number;
+        std::memcpy(&number, &bits, sizeof(number));
+        token.kind = Token::Number;
+        token.number = number;
+        return true;
+    }
+    case 0xCB: {
+        const uint64_t bits = next(width);
+        std::memcpy(&token.number, &bits, sizeof(token.number));
+        token.kind = Token::Number;
+        return true;
+    }
+    case 0xCC:
+    case 0xCD:
+    case 0xCE:
+    case 0xCF:
+        token.kind = Token::Number;
+        token.number = static_cast<double>(next(width));
+        return true;
+    case 0xD0:
+        token.kind = Token::Number;
+        token.number = static_cast<int8_t>(next(width));
+        return true;
+    case 0xD1:
+        token.kind = Token::Number;
+        token.number = static_cast<int16_t>(next(width));
+        return true;
+    case 0xD2:
+        token.kind = Token::Number;
+        token.number = static_cast<int32_t>(next(width));
+        return true;
+    case 0xD3:
+        token.kind = Token::Number;
+        token.number = static_cast<double>(static_cast<int64_t>(next(width)));
+        return true;
+    case 0xD4:
+    case 0xD5:
+    case 0xD6:
+    case 0xD7:
+    case 0xD8:
+        // Type byte and 1, 2, 4, 8 or 16 bytes of data
+        token.kind = Token::Other;
+        return payload(1 + (1u << (type - 0xD4)));
+    case 0xD9:
+    case 0xDA:
+    case 0xDB:
+        token.kind = Token::String;
+        return payload(static_cast<uint32_t>(next(width)));
+    case 0xDC:
+    case 0xDD:
+        token.kind = Token::Array;
+        token.size = static_cast<uint32_t>(next(width));
+        return true;
+    case 0xDE:
+    case 0xDF:
+        token.kind = Token::Object;
+        token.size = static_cast<uint32_t>(next(width));
+        return true;
+    default:
+        return fail("invalid MessagePack type");
+    }
+}
+
+bool
+CommandParser::skipMessagePackValue(const Token &token, int depth)
+{
+    if (token.kind != Token::Object && token.kind != Token::Array) {
+        return true;
+    }
+    if (depth > maxDepth) {
+        return fail("the message is nested too deeply");
+    }
+
+    const uint64_t values = token.kind == Token::Object ? uint64_t{token.size} * 2 : token.size;
+    for (uint64_t i = 0; i < values; i++) {
+        Token element;
+        if (!readMessagePackToken(element) || !skipMessagePackValue(element, depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,155 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_COMMAND_PARSER_H
+#define MARSIM_COMMAND_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+enum class CommandType : uint8_t {
+    Unknown,
+    Motors,
+    Pickup,
+    Drop,
+    ShootLaser,
+    LaserAngle,
+    RequestImage,
+    RequestImageBlurred,
+    ArmSpeeds,
+    ArmClose,
+    ArmOpen,
+    ArmFoldLock,
+    ArmFoldUnlock,
+    RobotLockBase,
+    RobotUnlockBase,
+    Count
+};
+
+// A control message, {"type": ..., "data": {...}}, with the known members of data decoded into fields
+struct Command
+{
+    enum Field : uint32_t {
+        Left = 1 << 0,
+        Right = 1 << 1,
+        Speed1 = 1 << 2,
+        Speed2 = 1 << 3,
+        Speed3 = 1 << 4,
+        Angle = 1 << 5,
+        Id = 1 << 6,
+        Index = 1 << 7
+    };
+
+    // Whether all the given fields were in data, as numbers
+    bool
+    has(uint32_t required) const
+    {
+        return (fields & required) == required;
+    }
+
+    CommandType type{CommandType::Unknown};
+    uint32_t fields{0};
+
+    float left{};
+    float right{};
+    float speed1{};
+    float speed2{};
+    float speed3{};
+    float angle{};
+    unsigned int id{};
+    unsigned int index{};
+};
+
+// Decodes control messages in JSON or MessagePack straight into a Command while reading them, without building a DOM or
+// allocating. Members that are not known are skipped.
+class CommandParser
+{
+public:
+    // Returns false if the message is malformed, error() tells why
+    bool parse(const char *data, size_t size, bool messagePack, Command &command);
+
+    const char *error() const;
+
+    static CommandType lookupType(std::string_view type);
+
+private:
+    // A scalar or the start of a container, as read from either format
+    struct Token
+    {
+        enum Kind {
+            Null,
+            Boolean,
+            Number,
+            String,
+            Object,
+            Array,
+            Other
+        };
+
+        Kind kind{Null};
+        double number{};
+        std::string_view string;
+
+        // Members or elements, MessagePack only
+        uint32_t size{};
+    };
+
+    bool parseJson(Command &command);
+
+    bool parseMessagePack(Command &command);
+
+    // Members of the message at depth 1, of data at depth 2. Called after the opening brace or map header.
+    bool parseJsonObject(Command &command, int depth);
+
+    bool parseMessagePackObject(Command &command, uint32_t members, int depth);
+
+    // What a key names, resolved before the value is read since that may overwrite an unescaped key
+    static uint32_t lookupMember(std::string_view key, int depth);
+
+    // Stores a scalar member value, returns false if the member is something else and the value has to be skipped
+    bool storeMember(Command &command, uint32_t member, const Token &token);
+
+    bool readJsonToken(Token &token);
+
+    bool readJsonString(std::string_view &string);
+
+    bool skipJsonValue(const Token &token, int depth);
+
+    bool readMessagePackToken(Token &token);
+
+    bool skipMessagePackValue(const Token &token, int depth);
+
+    void skipWhitespace();
+
+    bool fail(const char *message);
+
+    const char *position{};
+    const char *end{};
+    const char *errorMessage{""};
+    bool hasType{false};
+
+    // Strings with escapes are decoded here, longer ones cannot be a known name anyway
+    char unescaped[64];
+};
+
+#endif // MARSIM_COMMAND_PARSER_H
@@ -0,0 +1,329 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "compression.h"
+
+#include "message_writer.h"
+
+#include <initializer_list>
+#include <iterator>
+
+namespace {
+
+void
+writeSampleBatch(MessageWriter &writer, std::string_view type, size_t messages, void (*writeData)(MessageWriter &))
+{
+    writer.beginObject(2);
+    writer.key("msgs");
+    writer.beginArray(messages);
+    for (size_t i = 0; i < messages; i++) {
+        writer.beginObject(2);
+        writer.key("data");
+        writeData(writer);
+        writer.key("type");
+        writer.value(type);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.key("time");
+    writer.value(int64_t{1700000000000000000});
+    writer.endObject();
+}
+
+void
+writeWeatherSample(MessageWriter &writer, std::string_view key)
+{
+    writer.beginObject(3);
+    writer.key("id");
+    writer.value(1042u);
+    writer.key("pos");
+    writer.position(-108.f, 92.f);
+    writer.key(key);
+    if (key == "wind_vec") {
+        writer.position(0.25f, -1.5f);
+    } else {
+        writer.value(21.5f);
+    }
+    writer.endObject();
+}
+
+// The messages marsim publishes, the most frequent ones last where zlib finds them with the shortest distances
+std::string
+buildDictionary(MessageWriter::Format format)
+{
+    std::string dictionary;
+    MessageWriter writer;
+    writer.reset(&dictionary, format);
+
+    writeSampleBatch(writer, "arm", 1, [](MessageWriter &writer) {
+        writer.beginObject(11);
+        for (const char *arm : {"arm1", "arm2", "arm3"}) {
+            for (const char *key : {"_jointAngle", "_jointSpeed", "_motorSpeed"}) {
+                writer.key(std::string{arm} + key);
+                writer.value(0.f);
+            }
+        }
+        writer.key("arm_fold_locked");
+        writer.value(false);
+        writer.key("arm_opened");
+        writer.value(true);
+        writer.endObject();
+    });
+
+    writeSampleBatch(writer, "Proximity Sensor", 1, [](MessageWriter &writer) {
+        writer.beginObject(4);
+        writer.key("id");
+        writer.value(7u);
+        writer.key("pos");
+        writer.pose(-67.f, -37.f, 0.f);
+        writer.key("radius");
+        writer.value(15.f);
+        writer.key("sensed_objs");
+        const char *names[] = {"Alien", "Robot Wheel", "Robot Arm", "Pickup Sensor", "Stone"};
+        writer.beginArray(std::size(names));
+        for (const char *name : names) {
+            writer.beginObject(4);
+            writer.key("id");
+            writer.value(1337u);
+            writer.key("mass");
+            writer.value(2.5f);
+            writer.key("name");
+            writer.value(name);
+            writer.key("pos");
+            writer.pose(-60.5f, -30.25f, 1.5f);
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.endObject();
+    });
+
+    writeSampleBatch(writer, "Robot", 1, [](MessageWriter &writer) {
+        writer.beginObject(5);
+        writer.key("base_locked");
+        writer.value(false);
+        writer.key("battery");
+        writer.value(99.5);
+        writer.key("in_shadow");
+        writer.value(false);
+        writer.key("pos");
+        writer.pose(-67.f, -37.f, 0.f);
+        writer.key("storage");
+        writer.beginArray(0);
+        writer.endArray();
+        writer.endObject();
+    });
+
+    writeSampleBatch(writer, "Seismic Sensor", 1, [](MessageWriter &writer) { writeWeatherSample(writer, "shake_val"); });
+    writeSampleBatch(writer, "Wind Sensor", 1, [](MessageWriter &writer) { writeWeatherSample(writer, "wind_vec"); });
+    writeSampleBatch(
+        writer, "Temperature Sensor", 2, [](MessageWriter &writer) { writeWeatherSample(writer, "temp"); });
+
+    writeSampleBatch(writer, "lidar", 1, [](MessageWriter &writer) {
+        writer.beginObject(2);
+        writer.key("lidarDistance");
+        writer.beginArray(8);
+        for (int i = 0; i < 8; i++) {
+            writer.value(i < 4 ? 30.f : 12.5f);
+        }
+        writer.endArray();
+        writer.key("lidarIds");
+        writer.beginArray(8);
+        for (int i = 0; i < 8; i++) {
+            writer.value(i < 4 ? -1 : 12);
+        }
+        writer.endArray();
+        writer.endObject();
+    });
+
+    writeSampleBatch(writer, "RobotPos", 2, [](MessageWriter &writer) {
+        writer.beginObject(1);
+        writer.key("pos");
+        writer.pose(-67.f, -37.f, 0.f);
+        writer.endObject();
+    });
+
+    return dictionary;
+}
+
+} // namespace
+
+const std::string &
+getCompressionDictionary(bool messagePack)
+{
+    static const std::string json = buildDictionary(MessageWriter::Format::Json);
+    static const std::string msgPack = buildDictionary(MessageWriter::Format::MessagePack);
+    return messagePack ? msgPack : json;
+}
+
+Compressor::~Compressor()
+{
+    for (auto *stream : {&gzip, &zlib}) {
+        if (stream->initialized) {
+            deflateEnd(&stream->stream);
+        }
+    }
+}
+
+bool
+Compressor::compress(std::string_view data, int mode, bool messagePack, std::string &output)
+{
+    const auto start = std::chrono::steady_clock::now();
+    adaptLevel(start);
+
+    Stream &stream = mode == CompressionGZip ? gzip : zlib;
+    if (!stream.initialized) {
+        // 16 asks for a gzip header and trailer instead of the zlib ones
+        const int windowBits = mode == CompressionGZip ? 15 + 16 : 15;
+        if (deflateInit2(&stream.stream, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false;
+        }
+        stream.initialized = true;
+        stream.level = level;
+    } else {
+        deflateReset(&stream.stream);
+    }
+
+    if (stream.level != level) {
+        deflateParams(&stream.stream, level, Z_DEFAULT_STRATEGY);
+        stream.level = level;
+    }
+
+    if (mode == CompressionZLibDictionary) {
+        const auto &dictionary = getCompressionDictionary(messagePack);
+        deflateSetDictionary(&stream.stream, reinterpret_cast<const Bytef *>(dictionary.data()), dictionary.size());
+    }
+
+    output.resize(deflateBound(&stream.stream, data.size()));
+    stream.stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.stream.avail_in = static_cast<uInt>(data.size());
+    stream.stream.next_out = reinterpret_cast<Bytef *>(output.data());
+    stream.stream.avail_out = static_cast<uInt>(output.size());
+
+    const int rc = deflate(&stream.stream, Z_FINISH);
+    output.resize(output.size() - stream.stream.avail_out);
+
+    busy += std::chrono::steady_clock::now() - start;
+    return rc == Z_STREAM_END;
+}
+
+void
+Compressor::adaptLevel(std::chrono::steady_clock::time_point now)
+{
+    const auto period = now - periodStart;
+    if (period < std::chrono::milliseconds(250)) {
+        return;
+    }
+
+    const float usage = std::chrono::duration<float>(busy) / std::chrono::duration<float>(period);
+    if (usage > cpuBudget && level > 1) {
+        level--;
+    } else if (usage < cpuBudget / 2.f && level < 9) {
+        level++;
+    }
+
+    periodStart = now;
+    busy = {};
+}
+
+void
+Compressor::setCpuBudget(float budget)
+{
+    cpuBudget = budget;
+}
+
+int
+Compressor::getLevel() const
+{
+    return level;
+}
+
+Decompressor::~Decompressor()
+{
+    if (initialized) {
+        inflateEnd(&stream);
+    }
+}
+
+bool
+Decompressor::decompress(std::string_view data, std::string &output)
+{
+    if (!initialized) {
+        // 32 lets zlib detect gzip and zlib headers, so one stream serves both
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+            return false;
+        }
+        initialized = true;
+    } else {
+        inflateReset(&stream);
+    }
+
+    output.resize(output.capacity() > 0 ? output.capacity() : 4096);
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+
+    size_t written = 0;
+    while (true) {
+        stream.next_out = reinterpret_cast<Bytef *>(&output[written]);
+        stream.avail_out = static_cast<uInt>(output.size() - written);
+
+        int rc = inflate(&stream, Z_NO_FLUSH);
+        written = output.size() - stream.avail_out;
+
+        if (rc == Z_NEED_DICT) {
+            // The header names the dictionary by its Adler-32 checksum
+            bool found = false;
+            for (bool messagePack : {false, true}) {
+                const auto &dictionary = getCompressionDictionary(messagePack);
+                const auto id = adler32(adler32(0, nullptr, 0),
+                                        reinterpret_cast<const Bytef *>(dictionary.data()),
+                                        static_cast<uInt>(dictionary.size()));
+                if (id == stream.adler) {
+                    found = inflateSetDictionary(&stream,
+                                                 reinterpret_cast<const Bytef *>(dictionary.data()),
+                                                 static_cast<uInt>(dictionary.size())) == Z_OK;
+                    break;
+                }
+            }
+            if (!found) {
+                return false;
+            }
+            continue;
+        }
+        if (rc == Z_STREAM_END) {
+            break;
+        }
+        if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            return false;
+        }
+        if (stream.avail_out != 0) {
+            // Out of input before the end of the stream, use what there is like zlibcomplete did
+            if (stream.avail_in == 0) {
+                break;
+            }
+            return false;
+        }
+        output.resize(output.size() * 2);
+    }
+
+    output.resize(written);
+    return true;
+}
@@ -0,0 +1,107 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_COMPRESSION_H
+#define MARSIM_COMPRESSION_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <zlib.h>
+
+// Values of Settings::m_compressionSend and m_compressionReceive
+enum CompressionMode {
+    CompressionNone = 0,
+    CompressionGZip = 1,
+    CompressionZLib = 2,
+    // zlib with a preset dictionary of marsim's messages, for JSON or MessagePack, named by its id in the header
+    CompressionZLibDictionary = 3
+};
+
+// Preset dictionaries built from sample messages, the same in the simulator and in every decoder that links this
+const std::string &getCompressionDictionary(bool messagePack);
+
+// Compresses each batch as a complete stream, reusing one zlib stream per format. The level follows a CPU budget, the
+// fraction of wall time spent compressing, so bandwidth is saved where there is time for it.
+class Compressor
+{
+public:
+    Compressor() = default;
+
+    ~Compressor();
+
+    Compressor(const Compressor &) = delete;
+
+    Compressor &operator=(const Compressor &) = delete;
+
+    // Writes to output, which keeps its capacity between calls. Returns false if zlib failed.
+    bool compress(std::string_view data, int mode, bool messagePack, std::string &output);
+
+    void setCpuBudget(float budget);
+
+    int getLevel() const;
+
+private:
+    // Moves the level towards the budget, from the time spent in the last period
+    void adaptLevel(std::chrono::steady_clock::time_point now);
+
+    struct Stream
+    {
+        z_stream stream{};
+        bool initialized{false};
+        int level{0};
+    };
+
+    // The header is chosen when the stream is created, so gzip needs a stream of its own
+    Stream gzip;
+    Stream zlib;
+
+    int level{6};
+    float cpuBudget{0.05f};
+
+    std::chrono::steady_clock::time_point periodStart{std::chrono::steady_clock::now()};
+    std::chrono::steady_clock::duration busy{};
+};
+
+// Inflates gzip and zlib streams, with or without one of the preset dictionaries
+class Decompressor
+{
+public:
+    Decompressor() = default;
+
+    ~Decompressor();
+
+    Decompressor(const Decompressor &) = delete;
+
+    Decompressor &operator=(const Decompressor &) = delete;
+
+    // Writes to output, which keeps its capacity between calls. Returns false if the data is not a stream it can read.
+    bool decompress(std::string_view data, std::string &output);
+
+private:
+    z_stream stream{};
+    bool initialized{false};
+};
+
+#endif // MARSIM_COMPRESSION_H
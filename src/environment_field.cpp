@@ -0,0 +1,323 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "environment_field.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define MARSIM_FIELD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+// Temperatures of the emitters, each pulls the temperature towards its own with falling distance
+constexpr float tornadoTemperature = 5.f;
+constexpr float alienTemperature = 75.f;
+
+// Squared distance at which an emitter stops affecting temperature and earthquakes stop shaking
+constexpr float attenuationRange = 100000.f;
+
+// Wind blows from every alien with this magnitude, and from tornadoes with their own
+constexpr float alienWindMagnitude = 100.f;
+
+// Emitters are not points, the wind stops growing within a meter of them instead of going to infinity
+constexpr float minWindDistanceSquared = 1.f;
+
+// Wind of an emitter at the offset (dx, dy) from the sampled position, with the squared distance limited to at least
+// minDistanceSquared
+b2Vec2
+emitterWind(float dx, float dy, float magnitude, float minDistanceSquared)
+{
+    float attenuation = magnitude / std::max(dx * dx + dy * dy, minDistanceSquared);
+    return {dx * attenuation, dy * attenuation};
+}
+
+// Emitters compare equal if they affect the field in the same way
+template <typename Data>
+bool
+sameEmitters(const std::vector<Data> &a, const std::vector<Data> &b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Data &x, const Data &y) {
+        if constexpr (std::is_same_v<Data, TornadoData>) {
+            return x.pos == y.pos && x.magnitude == y.magnitude;
+        } else {
+            return x.pos == y.pos;
+        }
+    });
+}
+} // namespace
+
+void
+EnvironmentField::resize(b2Vec2 min, b2Vec2 max, float cellSize)
+{
+    this->cellSize = cellSize;
+    origin = min;
+    width = std::max(2, (int)std::ceil((max.x - min.x) / cellSize) + 1);
+    height = std::max(2, (int)std::ceil((max.y - min.y) / cellSize) + 1);
+    stride = (width + 3) & ~3;
+
+    // Two cells are enough for the interpolated rest of the field to be smooth around an emitter
+    nearFieldRadius = 2.f * cellSize;
+
+    const size_t cells = size_t(stride) * height;
+    temperature.assign(cells, ambientTemperature);
+    windX.assign(cells, 0.f);
+    windY.assign(cells, 0.f);
+    quakeDamping.assign(cells, 1.f);
+
+    rasterized = false;
+}
+
+void
+EnvironmentField::update(const std::vector<TornadoData> &tornadoes,
+                         const std::vector<AlienData> &aliens,
+                         const std::vector<VolcanoData> &volcanoes,
+                         float volcanoTemperature,
+                         bool earthquakeActive,
+                         b2Vec2 epicenter)
+{
+    if (sameEmitters(tornadoes, this->tornadoes) && sameEmitters(aliens, this->aliens) &&
+        sameEmitters(volcanoes, this->volcanoes) && volcanoTemperature == this->volcanoTemperature &&
+        earthquakeActive == this->earthquakeActive && (!earthquakeActive || epicenter == this->epicenter)) {
+        // Emitters at rest are likely to stay, the grid pays off
+        rasterize();
+        return;
+    }
+
+    this->tornadoes = tornadoes;
+    this->aliens = aliens;
+    this->volcanoes = volcanoes;
+    this->volcanoTemperature = volcanoTemperature;
+    this->earthquakeActive = earthquakeActive;
+    this->epicenter = epicenter;
+    rasterized = false;
+}
+
+void
+EnvironmentField::rasterize()
+{
+    if (rasterized) {
+        return;
+    }
+    rasterized = true;
+
+    ThreadPool::getInstance().parallelFor(height, 8, [this](int begin, int end) { rasterizeRows(begin, end); });
+}
+
+void
+EnvironmentField::rasterizeRows(int beginRow, int endRow)
+{
+#ifdef MARSIM_FIELD_SSE2
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 range = _mm_set1_ps(attenuationRange);
+    const __m128 inverseRange = _mm_set1_ps(1.f / attenuationRange);
+    const __m128 laneOffsets = _mm_mul_ps(_mm_set_ps(3.f, 2.f, 1.f, 0.f), _mm_set1_ps(cellSize));
+    const __m128 nearFieldSquared = _mm_set1_ps(nearFieldRadius * nearFieldRadius);
+
+    // Pulls the temperatures towards the emitter temperature, like glm::mix(emitter, temperature, attenuation)
+    auto mixTemperature = [&](__m128 &t, __m128 dx, __m128 dy, float scale, float emitterTemperature) {
+        __m128 distanceSquared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 attenuation = _mm_mul_ps(_mm_min_ps(_mm_mul_ps(_mm_set1_ps(scale), distanceSquared), range), inverseRange);
+        __m128 e = _mm_set1_ps(emitterTemperature);
+        t = _mm_add_ps(e, _mm_mul_ps(_mm_sub_ps(t, e), attenuation));
+    };
+
+    for (int row = beginRow; row < endRow; row++) {
+        const __m128 y = _mm_set1_ps(origin.y + row * cellSize);
+        const size_t rowStart = size_t(row) * stride;
+
+        for (int column = 0; column < stride; column += 4) {
+            const __m128 x = _mm_add_ps(_mm_set1_ps(origin.x + column * cellSize), laneOffsets);
+
+            __m128 t = _mm_set1_ps(ambientTemperature);
+            __m128 wx = _mm_setzero_ps();
+            __m128 wy = _mm_setzero_ps();
+
+            for (auto &&tornado : tornadoes) {
+                __m128 dx = _mm_sub_ps(_mm_set1_ps(tornado.pos.x), x);
+                __m128 dy = _mm_sub_ps(_mm_set1_ps(tornado.pos.y), y);
+                mixTemperature(t, dx, dy, 1.f, tornadoTemperature);
+
+                __m128 distanceSquared =
+                    _mm_max_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), nearFieldSquared);
+                __m128 attenuation = _mm_div_ps(_mm_set1_ps(tornado.magnitude), distanceSquared);
+                wx = _mm_add_ps(wx, _mm_mul_ps(dx, attenuation));
+                wy = _mm_add_ps(wy, _mm_mul_ps(dy, attenuation));
+            }
+
+            for (auto &&alien : aliens) {
+                __m128 dx = _mm_sub_ps(_mm_set1_ps(alien.pos.x), x);
+                __m128 dy = _mm_sub_ps(_mm_set1_ps(alien.pos.y), y);
+                mixTemperature(t, dx, dy, 100.f, alienTemperature);
+
+                __m128 distanceSquared =
+                    _mm_max_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), nearFieldSquared);
+                __m128 attenuation = _mm_div_ps(_mm_set1_ps(alienWindMagnitude), distanceSquared);
+                wx = _mm_add_ps(wx, _mm_mul_ps(dx, attenuation));
+                wy = _mm_add_ps(wy, _mm_mul_ps(dy, attenuation));
+            }
+
+            for (auto &&volcano : volcanoes) {
+                __m128 dx = _mm_sub_ps(_mm_set1_ps(volcano.pos.x), x);
+                __m128 dy = _mm_sub_ps(_mm_set1_ps(volcano.pos.y), y);
+                mixTemperature(t, dx, dy, 1.f, volcanoTemperature);
+            }
+
+            __m128 damping = one;
+            if (earthquakeActive) {
+                __m128 dx = _mm_sub_ps(_mm_set1_ps(epicenter.x), x);
+                __m128 dy = _mm_sub_ps(_mm_set1_ps(epicenter.y), y);
+                __m128 distanceSquared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+                damping = _mm_mul_ps(_mm_min_ps(distanceSquared, range), inverseRange);
+            }
+
+            _mm_storeu_ps(&temperature[rowStart + column], t);
+            _mm_storeu_ps(&windX[rowStart + column], wx);
+            _mm_storeu_ps(&windY[rowStart + column], wy);
+            _mm_storeu_ps(&quakeDamping[rowStart + column], damping);
+        }
+    }
+#else
+    for (int row = beginRow; row < endRow; row++) {
+        const float y = origin.y + row * cellSize;
+        const size_t rowStart = size_t(row) * stride;
+
+        for (int column = 0; column < stride; column++) {
+            auto cell = evaluate(origin.x + column * cellSize, y, nearFieldRadius * nearFieldRadius);
+            temperature[rowStart + column] = cell.temperature;
+            windX[rowStart + column] = cell.wind.x;
+            windY[rowStart + column] = cell.wind.y;
+            quakeDamping[rowStart + column] = cell.quakeDamping;
+        }
+    }
+#endif
+}
+
+EnvironmentSample
+EnvironmentField::evaluate(float x, float y, float minDistanceSquared) const
+{
+    auto attenuate = [](float dx, float dy, float scale) {
+        return std::min(scale * (dx * dx + dy * dy), attenuationRange) / attenuationRange;
+    };
+
+    float t = ambientTemperature;
+    b2Vec2 wind{0.f, 0.f};
+
+    for (auto &&tornado : tornadoes) {
+        float dx = tornado.pos.x - x, dy = tornado.pos.y - y;
+        t = tornadoTemperature + (t - tornadoTemperature) * attenuate(dx, dy, 1.f);
+        wind += emitterWind(dx, dy, tornado.magnitude, minDistanceSquared);
+    }
+
+    for (auto &&alien : aliens) {
+        float dx = alien.pos.x - x, dy = alien.pos.y - y;
+        t = alienTemperature + (t - alienTemperature) * attenuate(dx, dy, 100.f);
+        wind += emitterWind(dx, dy, alienWindMagnitude, minDistanceSquared);
+    }
+
+    for (auto &&volcano : volcanoes) {
+        float dx = volcano.pos.x - x, dy = volcano.pos.y - y;
+        t = volcanoTemperature + (t - volcanoTemperature) * attenuate(dx, dy, 1.f);
+    }
+
+    float damping = earthquakeActive ? attenuate(epicenter.x - x, epicenter.y - y, 1.f) : 1.f;
+    return {t, wind, damping};
+}
+
+EnvironmentSample
+EnvironmentField::sample(b2Vec2 position) const
+{
+    if (!rasterized || width == 0) {
+        return evaluate(position.x, position.y, minWindDistanceSquared);
+    }
+
+    // Clamped so that the four taps stay inside the grid
+    float fx = std::clamp((position.x - origin.x) / cellSize, 0.f, float(width - 1));
+    float fy = std::clamp((position.y - origin.y) / cellSize, 0.f, float(height - 1));
+    int x0 = std::min((int)fx, width - 2);
+    int y0 = std::min((int)fy, height - 2);
+    float tx = fx - x0;
+    float ty = fy - y0;
+
+    const size_t i00 = size_t(y0) * stride + x0;
+    const size_t i10 = i00 + 1;
+    const size_t i01 = i00 + stride;
+    const size_t i11 = i01 + 1;
+
+    auto bilinear = [&](const std::vector<float> &grid) {
+        float top = grid[i00] + (grid[i10] - grid[i00]) * tx;
+        float bottom = grid[i01] + (grid[i11] - grid[i01]) * tx;
+        return top + (bottom - top) * ty;
+    };
+
+    // The grid holds the wind of emitters as if they were never closer than the near field radius, which bilinear
+    // interpolation gets right. Emitters that are closer add the rest of their wind here.
+    b2Vec2 wind{bilinear(windX), bilinear(windY)};
+    const float nearFieldSquared = nearFieldRadius * nearFieldRadius;
+    auto addNearField = [&](b2Vec2 emitter, float magnitude) {
+        float dx = emitter.x - position.x, dy = emitter.y - position.y;
+        if (dx * dx + dy * dy < nearFieldSquared) {
+            wind += emitterWind(dx, dy, magnitude, minWindDistanceSquared);
+            wind -= emitterWind(dx, dy, magnitude, nearFieldSquared);
+        }
+    };
+    for (auto &&tornado : tornadoes) {
+        addNearField(tornado.pos, tornado.magnitude);
+    }
+    for (auto &&alien : aliens) {
+        addNearField(alien.pos, alienWindMagnitude);
+    }
+
+    return {bilinear(temperature), wind, bilinear(quakeDamping)};
+}
+
+nlohmann::json
+EnvironmentField::getJson()
+{
+    rasterize();
+
+    nlohmann::json j;
+    j["origin"] = {{"x", origin.x}, {"y", origin.y}};
+    j["cell_size"] = cellSize;
+    j["width"] = width;
+    j["height"] = height;
+
+    std::vector<float> temperatures, windXs, windYs;
+    temperatures.reserve(size_t(width) * height);
+    windXs.reserve(size_t(width) * height);
+    windYs.reserve(size_t(width) * height);
+    for (int row = 0; row < height; row++) {
+        const size_t rowStart = size_t(row) * stride;
+        temperatures.insert(temperatures.end(), &temperature[rowStart], &temperature[rowStart] + width);
+        windXs.insert(windXs.end(), &windX[rowStart], &windX[rowStart] + width);
+        windYs.insert(windYs.end(), &windY[rowStart], &windY[rowStart] + width);
+    }
+
+    j["temp"] = temperatures;
+    j["wind_x"] = windXs;
+    j["wind_y"] = windYs;
+    return j;
+}
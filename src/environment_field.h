@@ -0,0 +1,117 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_ENVIRONMENT_FIELD_H
+#define MARSIM_ENVIRONMENT_FIELD_H
+
+#include "box2d/b2_math.h"
+#include "json.hpp"
+
+#include <vector>
+
+struct TornadoData {
+    b2Vec2 pos;
+    float magnitude;
+    float radius;
+};
+
+struct VolcanoData {
+    b2Vec2 pos;
+    float magnitude;
+    float radius;
+};
+
+struct AlienData {
+    b2Vec2 pos;
+};
+
+// Everything the weather sensors pick up at a position
+struct EnvironmentSample {
+    float temperature;  // degrees Celsius
+    b2Vec2 wind;
+    float quakeDamping; // 0 at the epicenter of an active earthquake, 1 far away from it or without an earthquake
+};
+
+// Temperature, wind and earthquake damping of the emitters. Rasterizing costs every cell times every emitter, so it
+// is only done for the published map and once the emitters stood still for a step, after which sampling takes
+// constant time. While aliens and tornadoes move, which is on most steps, a sample sums up the emitters at its
+// position instead, which for the few weather sensors is far cheaper than rasterizing every step.
+//
+// On the grid, values between cell centers are interpolated bilinearly, and positions outside the grid take the value
+// of the nearest edge. Wind within a couple of cells of a tornado or an alien changes too fast for that, so it is
+// added from the emitters themselves at sample time.
+class EnvironmentField
+{
+public:
+    // Covers the rectangle from min to max with square cells of the given size
+    void resize(b2Vec2 min, b2Vec2 max, float cellSize);
+
+    // Takes the emitters of the step, and rasterizes them if they are the same as the last time
+    void update(const std::vector<TornadoData> &tornadoes,
+                const std::vector<AlienData> &aliens,
+                const std::vector<VolcanoData> &volcanoes,
+                float volcanoTemperature,
+                bool earthquakeActive,
+                b2Vec2 epicenter);
+
+    EnvironmentSample sample(b2Vec2 position) const;
+
+    // The whole grid, row by row from the minimum corner, rasterized if it is out of date
+    nlohmann::json getJson();
+
+    // Temperature far away from every emitter
+    static constexpr float ambientTemperature = 25.f;
+
+private:
+    // Rasterizes the emitters of the last update, does nothing if that is done already
+    void rasterize();
+
+    // Rasterizes the rows [beginRow, endRow) of every grid
+    void rasterizeRows(int beginRow, int endRow);
+
+    // Sums up the emitters at the position, with the squared distance to tornadoes and aliens limited to at least
+    // minDistanceSquared for the wind
+    EnvironmentSample evaluate(float x, float y, float minDistanceSquared) const;
+
+    b2Vec2 origin{};
+    float cellSize{1.f};
+    float nearFieldRadius{2.f}; // meters around an emitter where its wind is added at sample time
+    int width{}, height{};
+
+    // Rows are padded to a multiple of four cells, the kernels always work on four cells at a time
+    int stride{};
+
+    std::vector<float> temperature;
+    std::vector<float> windX, windY;
+    std::vector<float> quakeDamping;
+
+    // Emitters of the last update
+    std::vector<TornadoData> tornadoes;
+    std::vector<AlienData> aliens;
+    std::vector<VolcanoData> volcanoes;
+    float volcanoTemperature{};
+    bool earthquakeActive{false};
+    b2Vec2 epicenter{};
+    bool rasterized{false};
+};
+
+#endif // MARSIM_ENVIRONMENT_FIELD_H
@@ -44,6 +44,8 @@ Application::Application()
 	m_textLine = 30;
 	m_textIncrement = 18;
 	m_mouseJoint = NULL;
+	m_mouseWorld.SetZero();
+	m_middleMouseDown = false;
 	m_pointCount = 0;
 
 	m_destructionListener.application = this;
@@ -52,6 +54,8 @@ Application::Application()
 	m_world->SetDebugDraw(&g_debugDraw);
 
 	m_stepCount = 0;
+	m_simulationTime = 0.0;
+	m_lastTimeStep = 0.0f;
 
 	b2BodyDef bodyDef;
 	m_groundBody = m_world->CreateBody(&bodyDef);
@@ -204,6 +208,18 @@ void Application::MouseMove(const b2Vec2& p)
 	}
 }
 
+void Application::MiddleMouseDown(const b2Vec2& p)
+{
+	m_mouseWorld = p;
+	m_middleMouseDown = true;
+}
+
+void Application::MiddleMouseUp(const b2Vec2& p)
+{
+	m_mouseWorld = p;
+	m_middleMouseDown = false;
+}
+
 void Application::Step(Settings& settings)
 {
 	float timeStep = settings.m_hertz > 0.0f ? 1.0f / settings.m_hertz : float(0.0f);
@@ -247,6 +263,9 @@ void Application::Step(Settings& settings)
 		++m_stepCount;
 	}
 
+	m_simulationTime += timeStep;
+	m_lastTimeStep = timeStep;
+
 	if (settings.m_drawStats)
 	{
 		int32 bodyCount = m_world->GetBodyCount();
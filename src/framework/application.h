@@ -93,6 +93,11 @@ public:
 	virtual void MouseDown(const b2Vec2& p);
 	virtual void MouseUp(const b2Vec2& p);
 	virtual void MouseMove(const b2Vec2& p);
+	virtual void MiddleMouseDown(const b2Vec2& p);
+	virtual void MiddleMouseUp(const b2Vec2& p);
+
+	bool IsMiddleMouseDown() const { return m_middleMouseDown; }
+	b2Vec2 GetMouseWorld() const { return m_mouseWorld; }
 
 	// Let derived tests know that a joint was destroyed.
 	virtual void JointDestroyed(b2Joint* joint) { B2_NOT_USED(joint); }
@@ -123,7 +128,10 @@ protected:
 	b2World* m_world;
 	b2MouseJoint* m_mouseJoint;
 	b2Vec2 m_mouseWorld;
+	bool m_middleMouseDown;
 	int32 m_stepCount;
+	double m_simulationTime;
+	float m_lastTimeStep;
 	int32 m_textIncrement;
 	b2Profile m_maxProfile;
 	b2Profile m_totalProfile;
@@ -21,6 +21,11 @@
 // SOFTWARE.
 
 #include "draw.h"
+
+#define GLFW_INCLUDE_NONE
+#include "glad/gl.h"
+#include "GLFW/glfw3.h"
+
 #include <queue>
 #include <stdarg.h>
 #include <stdio.h>
@@ -995,6 +1000,51 @@ void DebugDraw::DrawImageTexture(unsigned int textureID, b2Vec2 pos, b2Vec2 scal
     m_images->Flush();
 }
 
+unsigned int DebugDraw::CreateImageTexture(const unsigned char* pixels, int width, int height, int channels)
+{
+	GLenum format;
+	if (channels == 1)
+	{
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		format = GL_RED;
+	}
+	else if (channels == 3)
+	{
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		format = GL_RGB;
+	}
+	else if (channels == 4)
+	{
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		format = GL_RGBA;
+	}
+	else
+	{
+		return 0;
+	}
+
+	GLuint textureID = 0;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	return textureID;
+}
+
+void DebugDraw::DestroyImageTexture(unsigned int textureID)
+{
+	if (textureID)
+	{
+		glDeleteTextures(1, &textureID);
+	}
+}
+
 //
 void DebugDraw::Flush()
 {
@@ -23,10 +23,6 @@
 #ifndef DRAW_H
 #define DRAW_H
 
-#define GLFW_INCLUDE_NONE
-#include "glad/gl.h"
-#include "GLFW/glfw3.h"
-
 #include "box2d/box2d.h"
 
 struct b2AABB;
@@ -85,6 +81,11 @@ public:
 
         void DrawImageTexture(unsigned int textureID, b2Vec2 pos, b2Vec2 scale);
 
+	// Uploads tightly packed 8-bit pixels with 1, 3 or 4 channels, returns 0 if no texture was created.
+	unsigned int CreateImageTexture(const unsigned char* pixels, int width, int height, int channels);
+
+	void DestroyImageTexture(unsigned int textureID);
+
 	void Flush();
 
 	bool m_showUI;
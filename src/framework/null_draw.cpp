@@ -0,0 +1,152 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Null implementation of the debug draw and camera used by the headless simulator.
+// Linked instead of draw.cpp, so objects can keep calling g_debugDraw without a GL context.
+
+#include "draw.h"
+
+DebugDraw g_debugDraw;
+Camera g_camera;
+
+Camera::Camera()
+{
+    m_width = 1280;
+    m_height = 800;
+    ResetView();
+}
+
+void
+Camera::ResetView()
+{
+    m_center.Set(0.0f, 20.0f);
+    m_zoom = 1.0f;
+}
+
+b2Vec2
+Camera::ConvertScreenToWorld(const b2Vec2 &screenPoint)
+{
+    return screenPoint;
+}
+
+b2Vec2
+Camera::ConvertWorldToScreen(const b2Vec2 &worldPoint)
+{
+    return worldPoint;
+}
+
+void
+Camera::BuildProjectionMatrix(float *m, float zBias)
+{
+}
+
+DebugDraw::DebugDraw()
+{
+    m_showUI = false;
+    m_points = nullptr;
+    m_lines = nullptr;
+    m_triangles = nullptr;
+    m_images = nullptr;
+}
+
+DebugDraw::~DebugDraw() = default;
+
+void
+DebugDraw::Create()
+{
+}
+
+void
+DebugDraw::Destroy()
+{
+}
+
+void
+DebugDraw::DrawPolygon(const b2Vec2 *vertices, int32 vertexCount, const b2Color &color)
+{
+}
+
+void
+DebugDraw::DrawSolidPolygon(const b2Vec2 *vertices, int32 vertexCount, const b2Color &color)
+{
+}
+
+void
+DebugDraw::DrawCircle(const b2Vec2 &center, float radius, const b2Color &color)
+{
+}
+
+void
+DebugDraw::DrawSolidCircle(const b2Vec2 &center, float radius, const b2Vec2 &axis, const b2Color &color)
+{
+}
+
+void
+DebugDraw::DrawSegment(const b2Vec2 &p1, const b2Vec2 &p2, const b2Color &color)
+{
+}
+
+void
+DebugDraw::DrawTransform(const b2Transform &xf)
+{
+}
+
+void
+DebugDraw::DrawPoint(const b2Vec2 &p, float size, const b2Color &color)
+{
+}
+
+void
+DebugDraw::DrawString(int x, int y, const char *string, ...)
+{
+}
+
+void
+DebugDraw::DrawString(const b2Vec2 &p, const char *string, ...)
+{
+}
+
+void
+DebugDraw::DrawAABB(b2AABB *aabb, const b2Color &color)
+{
+}
+
+void
+DebugDraw::DrawImageTexture(unsigned int textureID, b2Vec2 pos, b2Vec2 scale)
+{
+}
+
+unsigned int
+DebugDraw::CreateImageTexture(const unsigned char *pixels, int width, int height, int channels)
+{
+    return 0;
+}
+
+void
+DebugDraw::DestroyImageTexture(unsigned int textureID)
+{
+}
+
+void
+DebugDraw::Flush()
+{
+}
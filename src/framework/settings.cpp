@@ -60,6 +60,7 @@ void Settings::Save()
 	fprintf(file, "  \"windowWidth\": %d,\n", m_windowWidth);
 	fprintf(file, "  \"windowHeight\": %d,\n", m_windowHeight);
 	fprintf(file, "  \"hertz\": %.9g,\n", m_hertz);
+	fprintf(file, "  \"timeScale\": %.9g,\n", m_timeScale);
 	fprintf(file, "  \"velocityIterations\": %d,\n", m_velocityIterations);
 	fprintf(file, "  \"positionIterations\": %d,\n", m_positionIterations);
 	fprintf(file, "  \"drawShapes\": %s,\n", m_drawShapes ? "true" : "false");
@@ -135,6 +136,15 @@ void Settings::Load()
 			continue;
 		}
 
+		if (strncmp(fieldName.data(), "timeScale", fieldName.length()) == 0)
+		{
+			if (fieldValue.get_type() == sajson::TYPE_DOUBLE || fieldValue.get_type() == sajson::TYPE_INTEGER)
+			{
+				m_timeScale = float(fieldValue.get_number_value());
+			}
+			continue;
+		}
+
 		if (strncmp(fieldName.data(), "velocityIterations", fieldName.length()) == 0)
 		{
 			if (fieldValue.get_type() == sajson::TYPE_INTEGER)
@@ -52,6 +52,8 @@ struct Settings
 		m_enableSleep = true;
 		m_pause = false;
 		m_singleStep = false;
+		m_timeScale = 1.0f;
+		m_unthrottled = false;
                 m_useMessagePackSend = false;
                 m_useMessagePackReceive = false;
                 m_compressionSend = 0;
@@ -83,8 +85,10 @@ struct Settings
 	bool m_enableSleep;
 	bool m_pause;
 	bool m_singleStep;
+	float m_timeScale;  // Simulated seconds per wall clock second
+	bool m_unthrottled; // Step as fast as possible, ignoring m_timeScale
         static inline bool m_useMessagePackSend;
         static inline bool m_useMessagePackReceive;
-        static inline int m_compressionSend;  // 0 = no, 1 = gzip, 2 = zlib
+        static inline int m_compressionSend;  // 0 = no, 1 = gzip, 2 = zlib, 3 = zlib with a preset dictionary
         static inline int m_compressionReceive;
 };
@@ -27,6 +27,7 @@ FrictionZone::FrictionZone(Simulation *simulation, b2Vec2 pos, float radius, flo
 {
     this->dampingAngular = dampingAngular;
     this->dampingLinear = dampingLinear;
+    type = ObjectType::FrictionZone;
 }
 
 void
@@ -0,0 +1,217 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "gaussian_blur.h"
+#include "blur.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define MARSIM_BLUR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+// Floats per row in a vertical strip, 64 rows of a 4k image strip fit in L2
+constexpr int stripWidth = 64;
+
+// Rows are padded so that a four lane load of the last pixel stays inside the buffer
+constexpr int rowPadding = 4;
+} // namespace
+
+void
+GaussianBlur::blurImage(unsigned char *image, int width, int height, int channels, float sigma, bool addOriginal)
+{
+    const int blurChannels = std::min(channels, 3);
+    const int rowFloats = width * blurChannels;
+
+    int boxes[3];
+    Blur::std_to_box(boxes, sigma, 3);
+
+    // The box blurs are separable and linear, so all horizontal passes can run before all vertical passes
+    std::vector<float> horizontal(size_t(rowFloats) * height);
+
+    ThreadPool::getInstance().parallelFor(height, 16, [&](int begin, int end) {
+        std::vector<float> rowA(rowFloats + rowPadding), rowB(rowFloats + rowPadding);
+
+        for (int y = begin; y < end; y++) {
+            const unsigned char *pixels = image + size_t(y) * width * channels;
+            for (int x = 0; x < width; x++) {
+                for (int c = 0; c < blurChannels; c++) {
+                    rowA[x * blurChannels + c] = pixels[x * channels + c] / 255.f;
+                }
+            }
+
+            horizontalBox(rowA.data(), rowB.data(), width, blurChannels, boxes[0]);
+            horizontalBox(rowB.data(), rowA.data(), width, blurChannels, boxes[1]);
+            horizontalBox(rowA.data(), rowB.data(), width, blurChannels, boxes[2]);
+
+            std::memcpy(&horizontal[size_t(y) * rowFloats], rowB.data(), rowFloats * sizeof(float));
+        }
+    });
+
+    const int strips = (rowFloats + stripWidth - 1) / stripWidth;
+
+    ThreadPool::getInstance().parallelFor(strips, 1, [&](int begin, int end) {
+        std::vector<float> stripA(size_t(stripWidth) * height), stripB(size_t(stripWidth) * height);
+        std::vector<float> sums(stripWidth);
+
+        for (int strip = begin; strip < end; strip++) {
+            const int first = strip * stripWidth;
+            const int count = std::min(stripWidth, rowFloats - first);
+
+            for (int y = 0; y < height; y++) {
+                float *row = &stripA[size_t(y) * stripWidth];
+                std::memcpy(row, &horizontal[size_t(y) * rowFloats + first], count * sizeof(float));
+                std::fill(row + count, row + stripWidth, 0.f);
+            }
+
+            verticalBox(stripA.data(), stripB.data(), sums.data(), height, stripWidth, boxes[0]);
+            verticalBox(stripB.data(), stripA.data(), sums.data(), height, stripWidth, boxes[1]);
+            verticalBox(stripA.data(), stripB.data(), sums.data(), height, stripWidth, boxes[2]);
+
+            // Write the strip back into the 8-bit image, with the original on top if requested
+            for (int y = 0; y < height; y++) {
+                const float *row = &stripB[size_t(y) * stripWidth];
+                unsigned char *pixels = image + size_t(y) * width * channels;
+                for (int i = 0; i < count; i++) {
+                    const int x = (first + i) / blurChannels;
+                    const int c = (first + i) % blurChannels;
+                    unsigned char &pixel = pixels[x * channels + c];
+
+                    auto blurred = (unsigned char)std::min(255.f, std::max(0.f, 255.f * row[i]));
+                    if (addOriginal) {
+                        blurred = (unsigned char)std::min(255.f, std::max(0.f, blurred + 255.f * (pixel / 255.f)));
+                    }
+                    pixel = blurred;
+                }
+            }
+        }
+    });
+}
+
+void
+GaussianBlur::horizontalBox(const float *in, float *out, int width, int channels, int radius)
+{
+    const int r = radius;
+    const int c = channels;
+
+#ifdef MARSIM_BLUR_SSE2
+    // All channels of a pixel are summed in one register, lanes past the channel count are ignored
+    const __m128 iarr = _mm_set1_ps(1.f / (r + r + 1));
+    const __m128 fv = _mm_loadu_ps(in);
+    const __m128 lv = _mm_loadu_ps(in + (width - 1) * c);
+    __m128 val = _mm_mul_ps(_mm_set1_ps(float(r + 1)), fv);
+
+    for (int j = 0; j < r; j++) {
+        val = _mm_add_ps(val, _mm_loadu_ps(in + j * c));
+    }
+
+    // Each store spills into the next pixel, which is overwritten by the following store or lands in the padding
+    int ti = 0, li = 0, ri = r;
+    for (int j = 0; j <= r; j++) {
+        val = _mm_add_ps(val, _mm_sub_ps(_mm_loadu_ps(in + c * ri++), fv));
+        _mm_storeu_ps(out + c * ti++, _mm_mul_ps(val, iarr));
+    }
+    for (int j = r + 1; j < width - r; j++) {
+        val = _mm_add_ps(val, _mm_sub_ps(_mm_loadu_ps(in + c * ri++), _mm_loadu_ps(in + c * li++)));
+        _mm_storeu_ps(out + c * ti++, _mm_mul_ps(val, iarr));
+    }
+    for (int j = width - r; j < width; j++) {
+        val = _mm_add_ps(val, _mm_sub_ps(lv, _mm_loadu_ps(in + c * li++)));
+        _mm_storeu_ps(out + c * ti++, _mm_mul_ps(val, iarr));
+    }
+#else
+    const float iarr = 1.f / (r + r + 1);
+    for (int ch = 0; ch < c; ch++) {
+        float fv = in[ch], lv = in[(width - 1) * c + ch], val = (r + 1) * fv;
+        int ti = ch, li = ch, ri = ch + r * c;
+
+        for (int j = 0; j < r; j++) {
+            val += in[ch + j * c];
+        }
+        for (int j = 0; j <= r; j++, ri += c, ti += c) {
+            val += in[ri] - fv;
+            out[ti] = val * iarr;
+        }
+        for (int j = r + 1; j < width - r; j++, ri += c, li += c, ti += c) {
+            val += in[ri] - in[li];
+            out[ti] = val * iarr;
+        }
+        for (int j = width - r; j < width; j++, li += c, ti += c) {
+            val += lv - in[li];
+            out[ti] = val * iarr;
+        }
+    }
+#endif
+}
+
+void
+GaussianBlur::verticalBox(const float *in, float *out, float *sums, int height, int stripWidth, int radius)
+{
+    const int r = radius;
+    const int s = stripWidth;
+    const float *first = in;
+    const float *last = in + size_t(height - 1) * s;
+
+    // Running sums for all columns of the strip, updated a whole row at a time
+    auto update = [&](const float *add, const float *remove, float *target) {
+#ifdef MARSIM_BLUR_SSE2
+        const __m128 iarr = _mm_set1_ps(1.f / (r + r + 1));
+        for (int k = 0; k < s; k += 4) {
+            __m128 difference = _mm_sub_ps(_mm_loadu_ps(add + k), _mm_loadu_ps(remove + k));
+            __m128 val = _mm_add_ps(_mm_loadu_ps(sums + k), difference);
+            _mm_storeu_ps(sums + k, val);
+            _mm_storeu_ps(target + k, _mm_mul_ps(val, iarr));
+        }
+#else
+        const float iarr = 1.f / (r + r + 1);
+        for (int k = 0; k < s; k++) {
+            sums[k] += add[k] - remove[k];
+            target[k] = sums[k] * iarr;
+        }
+#endif
+    };
+
+    for (int k = 0; k < s; k++) {
+        sums[k] = (r + 1) * first[k];
+    }
+    for (int j = 0; j < r; j++) {
+        for (int k = 0; k < s; k++) {
+            sums[k] += in[size_t(j) * s + k];
+        }
+    }
+
+    int ti = 0, li = 0, ri = r;
+    for (int j = 0; j <= r; j++) {
+        update(in + size_t(ri++) * s, first, out + size_t(ti++) * s);
+    }
+    for (int j = r + 1; j < height - r; j++) {
+        update(in + size_t(ri++) * s, in + size_t(li++) * s, out + size_t(ti++) * s);
+    }
+    for (int j = height - r; j < height; j++) {
+        update(last, in + size_t(li++) * s, out + size_t(ti++) * s);
+    }
+}
@@ -0,0 +1,44 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_GAUSSIAN_BLUR_H
+#define MARSIM_GAUSSIAN_BLUR_H
+
+// Gaussian blur of 8-bit interleaved images, approximated by three box blurs with the same box sizes as
+// Blur::fast_gaussian_blur. The horizontal passes stream the image row by row, the vertical passes run on
+// cache sized column strips, and both are split over the thread pool.
+class GaussianBlur
+{
+public:
+    // Blurs the first min(channels, 3) channels of the image in place, other channels are left untouched.
+    // With addOriginal the unblurred image is added on top of the blurred one, saturating at 255.
+    static void blurImage(unsigned char *image, int width, int height, int channels, float sigma, bool addOriginal);
+
+private:
+    // One horizontal box blur pass over a row of interleaved float channels
+    static void horizontalBox(const float *in, float *out, int width, int channels, int radius);
+
+    // One vertical box blur pass over a strip of stripWidth floats per row
+    static void verticalBox(const float *in, float *out, float *sums, int height, int stripWidth, int radius);
+};
+
+#endif // MARSIM_GAUSSIAN_BLUR_H
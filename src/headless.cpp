@@ -0,0 +1,141 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Runs the simulation without a window, OpenGL context or user interface.
+// Debug drawing goes to the null draw sink (framework/null_draw.cpp).
+
+#include "framework/settings.h"
+#include "mqtt.h"
+#include "simulation.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static volatile std::sig_atomic_t s_quit = 0;
+
+static void
+SignalHandler(int)
+{
+    s_quit = 1;
+}
+
+static void
+PrintUsage()
+{
+    std::cout << "Usage: marsim_headless [options]\n"
+                 "  --init <file>             Init json file (default: data/init1.json)\n"
+                 "  --mqtt <address> <port>   Connect to an MQTT broker\n"
+                 "  --mqtt-id <id>            MQTT simulator instance id (default: 0)\n"
+                 "  --steps <n>               Quit after n simulation steps (default: run until interrupted)\n"
+                 "  --time-scale <x>          Simulated seconds per wall clock second (default: 1)\n"
+                 "  --unthrottled             Step as fast as possible\n"
+                 "  --verbose                 Print sent and received MQTT messages\n"
+              << std::endl;
+}
+
+int
+main(int argc, char **argv)
+{
+    std::string initJsonFilePath{"data/init1.json"};
+    std::string mqttAddress;
+    int mqttPort{8883};
+    long long maxSteps{-1};
+    bool verbose{false};
+
+    Settings settings;
+    // Nothing is rendered, so skip walking the bodies and joints in b2World::DebugDraw
+    settings.m_drawShapes = false;
+    settings.m_drawJoints = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--init") == 0 && i + 1 < argc) {
+            initJsonFilePath = argv[++i];
+        } else if (strcmp(argv[i], "--mqtt") == 0 && i + 2 < argc) {
+            mqttAddress = argv[++i];
+            mqttPort = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mqtt-id") == 0 && i + 1 < argc) {
+            Mqtt::mqttInstanceId = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            maxSteps = std::stoll(argv[++i]);
+        } else if (strcmp(argv[i], "--time-scale") == 0 && i + 1 < argc) {
+            settings.m_timeScale = std::stof(argv[++i]);
+        } else if (strcmp(argv[i], "--unthrottled") == 0) {
+            settings.m_unthrottled = true;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            PrintUsage();
+            return strcmp(argv[i], "--help") == 0 ? 0 : -1;
+        }
+    }
+
+    std::signal(SIGINT, SignalHandler);
+    std::signal(SIGTERM, SignalHandler);
+
+    Mqtt::getInstance().printSendingMsgs = verbose;
+    Mqtt::getInstance().printReceivingMsgs = verbose;
+
+    Simulation *simulation = Simulation::Create(initJsonFilePath);
+    Mqtt::getInstance().setSimulationPtr(simulation);
+
+    if (!mqttAddress.empty()) {
+        Mqtt::getInstance().connectMqtt(mqttAddress, mqttPort);
+    }
+
+    std::chrono::duration<double> sleepAdjust(0.0);
+
+    while (!s_quit && (maxSteps < 0 || simulation->GetStepCount() < maxSteps)) {
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+        simulation->Step(settings);
+        Mqtt::getInstance().processMqtt();
+
+        // Throttle to cap at the physics rate scaled by the time scale, same as the windowed simulator.
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+        std::chrono::duration<double> target(0.0);
+        if (!settings.m_unthrottled && settings.m_hertz > 0.0f && settings.m_timeScale > 0.0f) {
+            target = std::chrono::duration<double>(1.0 / (settings.m_hertz * settings.m_timeScale));
+        }
+        std::chrono::duration<double> timeUsed = t2 - t1;
+        std::chrono::duration<double> sleepTime = target - timeUsed + sleepAdjust;
+        if (sleepTime > std::chrono::duration<double>(0)) {
+            std::this_thread::sleep_for(sleepTime);
+        }
+
+        std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+        std::chrono::duration<double> frameTime = t3 - t1;
+
+        // Compute the sleep adjustment using a low pass filter
+        sleepAdjust = 0.9 * sleepAdjust + 0.1 * (target - frameTime);
+    }
+
+    std::cout << "Stopped after " << simulation->GetStepCount() << " steps, " << simulation->GetSimulationTime()
+              << " simulated seconds." << std::endl;
+
+    delete simulation;
+
+    return 0;
+}
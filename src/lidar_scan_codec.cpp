@@ -0,0 +1,306 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "lidar_scan_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr uint8_t scanVersion = 1;
+constexpr uint8_t deltaFlag = 1;
+constexpr size_t headerSize = 14;
+
+void
+appendVarint(std::string &out, uint32_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+uint32_t
+zigzag(int32_t value)
+{
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+int32_t
+unzigzag(uint32_t value)
+{
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+bool
+readVarint(const char *&position, const char *end, uint32_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (position == end) {
+            return false;
+        }
+        const auto byte = static_cast<uint8_t>(*position++);
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T>
+void
+appendLittleEndian(std::string &out, T value)
+{
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    std::reverse(bytes, bytes + sizeof(T));
+#endif
+    out.append(reinterpret_cast<const char *>(bytes), sizeof(T));
+}
+
+template <typename T>
+T
+readLittleEndian(const char *data)
+{
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, data, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    std::reverse(bytes, bytes + sizeof(T));
+#endif
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+bool
+LidarScanEncoder::begin(size_t rays, float angularResolution, float maxRange, bool keyframe)
+{
+    if (rays > maxRays) {
+        return false;
+    }
+
+    this->angularResolution = angularResolution;
+
+    // Millimetres, coarser only for a range that would not fit
+    const float unit = std::max(0.001f, maxRange / 65535.f);
+    delta = !keyframe && hasPrevious && previousRanges.size() == rays && unit == rangeUnit;
+    rangeUnit = unit;
+
+    ranges.clear();
+    ids.clear();
+    runLength = 0;
+    return true;
+}
+
+void
+LidarScanEncoder::add(float distance, int id)
+{
+    ranges.push_back(static_cast<uint16_t>(std::clamp(std::lround(distance / rangeUnit), 0l, 65535l)));
+
+    if (runLength && id == runId) {
+        runLength++;
+        return;
+    }
+    if (runLength) {
+        appendVarint(ids, runLength);
+        appendVarint(ids, zigzag(runId));
+    }
+    runId = id;
+    runLength = 1;
+}
+
+void
+LidarScanEncoder::finish(std::string &out)
+{
+    if (runLength) {
+        appendVarint(ids, runLength);
+        appendVarint(ids, zigzag(runId));
+    }
+
+    out.clear();
+    out.push_back(static_cast<char>(scanVersion));
+    out.push_back(static_cast<char>(delta ? deltaFlag : 0));
+    appendLittleEndian(out, sequence);
+    appendLittleEndian(out, static_cast<uint16_t>(ranges.size()));
+    appendLittleEndian(out, rangeUnit);
+    appendLittleEndian(out, angularResolution);
+
+    if (delta) {
+        uint32_t unchanged = 0;
+        for (size_t i = 0; i < ranges.size(); i++) {
+            const int32_t change = int32_t{ranges[i]} - int32_t{previousRanges[i]};
+            if (change == 0) {
+                unchanged++;
+                continue;
+            }
+            appendVarint(out, unchanged);
+            appendVarint(out, zigzag(change));
+            unchanged = 0;
+        }
+        if (unchanged) {
+            appendVarint(out, unchanged);
+        }
+    } else {
+        for (uint16_t range : ranges) {
+            appendLittleEndian(out, range);
+        }
+    }
+    out.append(ids);
+
+    std::swap(ranges, previousRanges);
+    hasPrevious = true;
+    sequence++;
+}
+
+bool
+LidarScanDecoder::decode(std::string_view data, std::vector<float> &distances, std::vector<int> &ids)
+{
+    if (data.size() < headerSize || static_cast<uint8_t>(data[0]) != scanVersion) {
+        return false;
+    }
+
+    const bool isDeltaFrame = data[1] & deltaFlag;
+    const auto frameSequence = readLittleEndian<uint16_t>(data.data() + 2);
+    const auto rays = readLittleEndian<uint16_t>(data.data() + 4);
+    const auto rangeUnit = readLittleEndian<float>(data.data() + 6);
+    angularResolution = readLittleEndian<float>(data.data() + 10);
+
+    // A delta only makes sense on top of the scan right before it
+    if (isDeltaFrame && (!hasPrevious || frameSequence != static_cast<uint16_t>(sequence + 1) || ranges.size() != rays)) {
+        hasPrevious = false;
+        return false;
+    }
+
+    const char *position = data.data() + headerSize;
+    const char *end = data.data() + data.size();
+
+    ranges.resize(rays);
+    if (isDeltaFrame) {
+        size_t ray = 0;
+        while (ray < rays) {
+            uint32_t unchanged, change;
+            if (!readVarint(position, end, unchanged) || unchanged > rays - ray) {
+                hasPrevious = false;
+                return false;
+            }
+            ray += unchanged;
+            if (ray == rays) {
+                break;
+            }
+            if (!readVarint(position, end, change)) {
+                hasPrevious = false;
+                return false;
+            }
+            ranges[ray] = static_cast<uint16_t>(ranges[ray] + unzigzag(change));
+            ray++;
+        }
+    } else {
+        if (static_cast<size_t>(end - position) < rays * sizeof(uint16_t)) {
+            hasPrevious = false;
+            return false;
+        }
+        for (auto &range : ranges) {
+            range = readLittleEndian<uint16_t>(position);
+            position += sizeof(uint16_t);
+        }
+    }
+
+    distances.resize(rays);
+    for (size_t i = 0; i < rays; i++) {
+        distances[i] = ranges[i] * rangeUnit;
+    }
+
+    ids.clear();
+    while (ids.size() < rays) {
+        uint32_t length, id;
+        if (!readVarint(position, end, length) || !readVarint(position, end, id) || length > rays - ids.size()) {
+            hasPrevious = false;
+            return false;
+        }
+        ids.insert(ids.end(), length, unzigzag(id));
+    }
+
+    hasPrevious = true;
+    delta = isDeltaFrame;
+    sequence = frameSequence;
+    return true;
+}
+
+bool
+LidarScanDecoder::isDelta() const
+{
+    return delta;
+}
+
+uint16_t
+LidarScanDecoder::getSequence() const
+{
+    return sequence;
+}
+
+float
+LidarScanDecoder::getAngularResolution() const
+{
+    return angularResolution;
+}
+
+bool
+decodeBase64(std::string_view text, std::string &out)
+{
+    out.clear();
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : text) {
+        int value;
+        if (c >= 'A' && c <= 'Z') {
+            value = c - 'A';
+        } else if (c >= 'a' && c <= 'z') {
+            value = c - 'a' + 26;
+        } else if (c >= '0' && c <= '9') {
+            value = c - '0' + 52;
+        } else if (c == '+') {
+            value = 62;
+        } else if (c == '/') {
+            value = 63;
+        } else if (c == '=') {
+            break;
+        } else {
+            return false;
+        }
+
+        bits = (bits << 6) | value;
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            out.push_back(static_cast<char>((bits >> count) & 0xFF));
+        }
+    }
+    return true;
+}
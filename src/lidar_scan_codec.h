@@ -0,0 +1,95 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_LIDAR_SCAN_CODEC_H
+#define MARSIM_LIDAR_SCAN_CODEC_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compact binary lidar scans, published as {"scan": <bytes>} instead of the two arrays. Little endian:
+//
+//   u8  version, 1
+//   u8  flags, 1 for a delta frame
+//   u16 sequence, counts every scan so a decoder notices a missed one
+//   u16 ray count
+//   f32 metres per range step
+//   f32 degrees between rays
+//   ranges, in steps: key frames have a u16 per ray. Delta frames have the changes since the last scan, as pairs of
+//       varint rays left unchanged, zigzag varint change of the next ray, until all rays are covered.
+//   ids, as runs covering all rays: varint length, zigzag varint id (-1 where nothing was hit)
+class LidarScanEncoder
+{
+public:
+    // The ray count is a u16 in the header
+    static constexpr size_t maxRays = UINT16_MAX;
+
+    // Starts a scan. It is a delta frame unless keyframe is set or there is no previous scan with the same rays.
+    // Returns false, without starting a scan, for more than maxRays rays.
+    bool begin(size_t rays, float angularResolution, float maxRange, bool keyframe);
+
+    void add(float distance, int id);
+
+    // Replaces the contents of out, which keeps its capacity
+    void finish(std::string &out);
+
+private:
+    uint16_t sequence{0};
+    float angularResolution{};
+    float rangeUnit{};
+    bool delta{false};
+
+    std::vector<uint16_t> ranges;
+    std::vector<uint16_t> previousRanges;
+    bool hasPrevious{false};
+
+    std::string ids;
+    int runId{0};
+    uint32_t runLength{0};
+};
+
+class LidarScanDecoder
+{
+public:
+    // Returns false if the data is malformed, or a delta frame that does not follow the last decoded scan
+    bool decode(std::string_view data, std::vector<float> &distances, std::vector<int> &ids);
+
+    bool isDelta() const;
+
+    uint16_t getSequence() const;
+
+    float getAngularResolution() const;
+
+private:
+    std::vector<uint16_t> ranges;
+    bool hasPrevious{false};
+    bool delta{false};
+    uint16_t sequence{0};
+    float angularResolution{};
+};
+
+// For scans that came as base64 strings in JSON. Returns false on characters outside the alphabet.
+bool decodeBase64(std::string_view text, std::string &out);
+
+#endif // MARSIM_LIDAR_SCAN_CODEC_H
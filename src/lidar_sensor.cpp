@@ -24,66 +24,188 @@
 #include "object.h"
 #include "mqtt.h"
 #include "raycast.h"
+#include "thread_pool.h"
+
+#include <cmath>
+#include <iostream>
 
 LidarSensor::LidarSensor(Simulation *simulation, float radius, b2Vec2 position)
 {
     this->simulation = simulation;
     this->radius = radius;
     this->position = position;
+
+    broadcastHandle = simulation->Schedule(broadcastInterval, [this] { publish(); });
+}
+
+LidarSensor::~LidarSensor()
+{
+    simulation->Unschedule(broadcastHandle);
 }
 
 void
 LidarSensor::update()
 {
-    castRays();
-
-    if (broadcastCounter % broadcastFrequency == 0) {
-        nlohmann::json j;
-        std::vector<float> distances;
-        std::vector<int> ids;
-        for(auto && i : lidarValues)
-        {
-            distances.push_back(i.distance);
-            ids.push_back(i.id);
+    if (visualizeEveryFrame) {
+        getScan();
+        drawRays();
+    }
+}
+
+void
+LidarSensor::publish()
+{
+    auto writer = Mqtt::getInstance().beginMessage("out/sensors/lidar", "lidar");
+    if (!writer) {
+        return;
+    }
+
+    getScan();
+
+    const auto &topicSetting = Mqtt::getInstance().getTopicSetting("out/sensors/lidar");
+
+    // A delta only decodes on top of the scan right before it. Latest value topics replace that scan in the queue,
+    // and a switch of the message format or a full outbound queue throws it away.
+    const unsigned int discarded = Mqtt::getInstance().getDiscardedCount("out/sensors/lidar");
+    const bool keyframe = topicSetting.latestValue || discarded != compactScansDiscarded ||
+                          topicSetting.keyframeInterval <= 1 || compactScans % topicSetting.keyframeInterval == 0;
+
+    // Scans with more rays than the compact form can count are sent as arrays
+    if (topicSetting.compact && scanEncoder.begin(lidarValues.size(), angularResolution, radius, keyframe)) {
+        compactScans++;
+        compactScansDiscarded = discarded;
+
+        for (auto &&i : lidarValues) {
+            scanEncoder.add(i.distance, i.id);
         }
-        j["lidarDistance"] = distances;
-        j["lidarIds"] = ids;
+        scanEncoder.finish(encodedScan);
 
-        Mqtt::getInstance().send("out/sensors/lidar", "lidar", j);
+        writer->beginObject(1);
+        writer->key("scan");
+        writer->binary(encodedScan);
+        writer->endObject();
+
+        Mqtt::getInstance().endMessage();
+        return;
     }
 
-    broadcastCounter++;
+    writer->beginObject(2);
+    writer->key("lidarDistance");
+    writer->beginArray(lidarValues.size());
+    for (auto &&i : lidarValues) {
+        writer->value(i.distance);
+    }
+    writer->endArray();
+    writer->key("lidarIds");
+    writer->beginArray(lidarValues.size());
+    for (auto &&i : lidarValues) {
+        writer->value(i.id);
+    }
+    writer->endArray();
+    writer->endObject();
+
+    Mqtt::getInstance().endMessage();
+}
+
+const std::vector<LidarSensor::LidarValue> &
+LidarSensor::getScan()
+{
+    if (scanStep != simulation->GetStepCount() || scanPosition != position) {
+        castRays();
+    }
+    return lidarValues;
 }
 
 void
 LidarSensor::castRays()
 {
-    lidarValues = {};
-    for (int i = 0; i < 360; i++) {
-        float anglerad = b2_pi * float(i) / 180.0f;
-        b2Vec2 point1 = position;
-        b2Vec2 d(radius * cosf(anglerad), radius * sinf(anglerad));
-        b2Vec2 point2 = point1 + d;
-
-        Raycast callback;
-        simulation->GetWorld()->RayCast(&callback, point1, point2);
-
-        if (callback.m_hit) {
-            g_debugDraw.DrawPoint(callback.m_point, 5.0f, b2Color(0.4f, 0.9f, 0.4f));
-            g_debugDraw.DrawSegment(point1, callback.m_point, b2Color(0.8f, 0.8f, 0.8f));
-            b2Vec2 head = callback.m_point + 0.5f * callback.m_normal;
-            g_debugDraw.DrawSegment(callback.m_point, head, b2Color(0.9f, 0.9f, 0.4f));
-
-            b2Vec2 diff = callback.m_point - point1;
-            lidarValues.push_back({diff.Length(), (int)callback.m_hit->GetObjectId()});
-        } else {
-            g_debugDraw.DrawSegment(point1, point2, b2Color(0.8f, 0.8f, 0.8f));
-            lidarValues.push_back({radius, -1});
+    scanStep = simulation->GetStepCount();
+    scanPosition = position;
+
+    lidarValues.resize(rayCount);
+
+    // The world is not stepped while the workers run, so the read-only ray casts can share it
+    const b2World *world = simulation->GetWorld();
+    const b2Vec2 point1 = position;
+
+    ThreadPool::getInstance().parallelFor(rayCount, 64, [&](int begin, int end) {
+        const int count = end - begin;
+
+        std::vector<Raycast> callbacks(count);
+        std::vector<b2RayCastCallback *> callbackPointers(count);
+        std::vector<b2Vec2> points2(count);
+
+        for (int i = 0; i < count; i++) {
+            float anglerad = b2_pi * angularResolution * float(begin + i) / 180.0f;
+            points2[i] = point1 + b2Vec2(radius * cosf(anglerad), radius * sinf(anglerad));
+            callbackPointers[i] = &callbacks[i];
+        }
+
+        // Neighbouring rays are traversed together as packets through the broad-phase
+        world->RayCastPacket(callbackPointers.data(), point1, points2.data(), count);
+
+        for (int i = 0; i < count; i++) {
+            if (callbacks[i].m_hit) {
+                b2Vec2 diff = callbacks[i].m_point - point1;
+                lidarValues[begin + i] = {diff.Length(), (int)callbacks[i].m_hit->GetObjectId()};
+            } else {
+                lidarValues[begin + i] = {radius, -1};
+            }
+        }
+    });
+}
+
+void
+LidarSensor::drawRays()
+{
+    for (int i = 0; i < (int)lidarValues.size(); i++) {
+        float anglerad = b2_pi * angularResolution * float(i) / 180.0f;
+        b2Vec2 dir(cosf(anglerad), sinf(anglerad));
+        b2Vec2 point2 = scanPosition + lidarValues[i].distance * dir;
+
+        if (lidarValues[i].id != -1) {
+            g_debugDraw.DrawPoint(point2, 5.0f, b2Color(0.4f, 0.9f, 0.4f));
         }
+        g_debugDraw.DrawSegment(scanPosition, point2, b2Color(0.8f, 0.8f, 0.8f));
     }
 }
+
 void
 LidarSensor::setPosition(b2Vec2 position)
 {
     this->position = position;
 }
+
+void
+LidarSensor::setAngularResolution(float degrees)
+{
+    const int count = degrees > 0.f ? (int)std::lround(360.f / degrees) : 0;
+    if (count < 1 || std::abs(count * degrees - 360.f) > 1e-3f) {
+        std::cerr << "Invalid lidar angular resolution " << degrees << ", 360 must be a multiple of it" << std::endl;
+        return;
+    }
+
+    angularResolution = degrees;
+    rayCount = count;
+    scanStep = -1;
+}
+
+float
+LidarSensor::getAngularResolution()
+{
+    return angularResolution;
+}
+
+void
+LidarSensor::setFrequency(float hertz)
+{
+    if (hertz <= 0.f) {
+        std::cerr << "Invalid lidar frequency " << hertz << std::endl;
+        return;
+    }
+
+    broadcastInterval = 1.f / hertz;
+
+    simulation->Unschedule(broadcastHandle);
+    broadcastHandle = simulation->Schedule(broadcastInterval, [this] { publish(); });
+}
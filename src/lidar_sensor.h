@@ -25,6 +25,7 @@
 
 #include "simulation.h"
 #include "json.hpp"
+#include "lidar_scan_codec.h"
 
 class LidarSensor
 {
@@ -32,25 +33,62 @@ public:
 
     LidarSensor(Simulation* simulation, float radius, b2Vec2 position);
 
+    ~LidarSensor();
+
     void setPosition(b2Vec2 position);
 
+    // Degrees between two neighbouring rays, 360 must be a multiple of it
+    void setAngularResolution(float degrees);
+
+    float getAngularResolution();
+
+    // Scans published per simulated second
+    void setFrequency(float hertz);
+
+    // Scans and draws the rays if visualizeEveryFrame is set
     void update();
 
+    // Scans and publishes, called by the simulation every broadcast interval
+    void publish();
+
+    // Casts the rays in parallel on the thread pool as ray packets, workers only write to their own lidarValues slots
     void castRays();
 
-protected:
+    void drawRays();
 
     struct LidarValue{
         float distance;
         int id;
     };
+
+    // Returns the scan for the current step and position, casting the rays only if it is out of date
+    const std::vector<LidarValue> &getScan();
+
+    // Cast and draw the rays every step, not only on the steps that publish
+    static inline bool visualizeEveryFrame{false};
+
+protected:
+
     std::vector<LidarValue> lidarValues;
 
     float radius{15.f};
     b2Vec2 position;
 
-    unsigned int broadcastCounter{0};
-    int broadcastFrequency = 30;
+    float angularResolution{1.f}; // degrees
+    int rayCount{360};
+
+    // Step and position of the last scan
+    int32 scanStep{-1};
+    b2Vec2 scanPosition{};
+
+    float broadcastInterval = 0.5f; // seconds
+    SlotHandle broadcastHandle;
+
+    // For topics that take compact scans
+    LidarScanEncoder scanEncoder;
+    std::string encodedScan;
+    int compactScans{0};
+    unsigned int compactScansDiscarded{0};
 
     Simulation* simulation;
 };
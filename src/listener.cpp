@@ -25,7 +25,12 @@
 
 #include <json.hpp>
 #include <mosquitto.h>
-#include <zlc/zlibcomplete.hpp>
+
+#include "compression.h"
+#include "lidar_scan_codec.h"
+#include "pose_codec.h"
+
+#include <unordered_map>
 
 bool isConnected = false;
 
@@ -35,6 +40,71 @@ int recvBytesTotal = 0;
 int useCompression = 0;
 int useMessagepack = 0;
 
+Decompressor decompressor;
+std::string decompressed;
+
+// Delta frames build on the last scan of the same topic
+std::unordered_map<std::string, LidarScanDecoder> scanDecoders;
+
+// Binary values are MessagePack bin, or base64 strings in JSON
+bool
+getBytes(const nlohmann::json &value, std::string &bytes)
+{
+    if (value.is_binary()) {
+        bytes.assign(value.get_binary().begin(), value.get_binary().end());
+        return true;
+    }
+    return value.is_string() && decodeBase64(value.get<std::string>(), bytes);
+}
+
+// Expands a compact lidar scan into the arrays it replaces
+void
+expandLidarScan(const std::string &topic, nlohmann::json &message)
+{
+    if (!message.is_object() || message.value("type", "") != "lidar" || !message["data"].is_object() ||
+        !message["data"].contains("scan")) {
+        return;
+    }
+
+    std::string bytes;
+    if (!getBytes(message["data"]["scan"], bytes)) {
+        return;
+    }
+
+    std::vector<float> distances;
+    std::vector<int> ids;
+    auto &decoder = scanDecoders[topic];
+    if (!decoder.decode(bytes, distances, ids)) {
+        message["data"] = "Could not decode the scan, waiting for a key frame";
+        return;
+    }
+
+    message["data"] = {{"lidarDistance", distances},
+                       {"lidarIds", ids},
+                       {"angularResolution", decoder.getAngularResolution()},
+                       {"delta", decoder.isDelta()},
+                       {"sequence", decoder.getSequence()}};
+}
+
+// Expands a fixed-point robot pose into the object it replaces
+void
+expandPose(nlohmann::json &message)
+{
+    if (!message.is_object() || message.value("type", "") != "RobotPos" || !message["data"].is_object() ||
+        !message["data"].contains("pose")) {
+        return;
+    }
+
+    std::string bytes;
+    float x, y, r;
+    if (!getBytes(message["data"]["pose"], bytes) || !decodePose(bytes, x, y, r)) {
+        message["data"] = "Could not decode the pose";
+        return;
+    }
+
+    message["data"] = {{"pos", {{"r", r}, {"x", x}, {"y", y}}}};
+}
+
 // shows if connected correctly
 void
 on_connect_listener(struct mosquitto *mosq, void *userdata, int result)
@@ -59,13 +129,13 @@ on_message_listener(struct mosquitto *mosq, void *userdata, const struct mosquit
 
         std::string payloadStr((char *)message->payload, message->payloadlen);
 
-        // Decompress
-        if (useCompression == 2) {
-            zlibcomplete::GZipDecompressor gZipDecompressor;
-            payloadStr = gZipDecompressor.decompress(payloadStr);
-        } else if (useCompression == 1) {
-            zlibcomplete::ZLibDecompressor zLibDecompressor{};
-            payloadStr = zLibDecompressor.decompress(payloadStr);
+        // Decompress, gzip and zlib are told apart by their headers and the dictionary by its id
+        if (useCompression) {
+            if (decompressor.decompress(payloadStr, decompressed)) {
+                payloadStr = decompressed;
+            } else {
+                printf("(could not decompress) ");
+            }
         }
 
         try {
@@ -75,6 +145,12 @@ on_message_listener(struct mosquitto *mosq, void *userdata, const struct mosquit
             } else {
                 j = nlohmann::json::parse(payloadStr);
             }
+            if (j.contains("msgs")) {
+                for (auto &&msg : j["msgs"]) {
+                    expandLidarScan(message->topic, msg);
+                    expandPose(msg);
+                }
+            }
             printf("%s\n", j.dump(4).c_str());
         } catch (std::exception e) {
             printf("%s\n", (char *)message->payload);
@@ -120,7 +196,7 @@ int main(){
     std::cout << "Use MESSAGEPACK decoding? Enter 1 for yes, 0 for no: ";
     std::cin >> useMessagepack;
 
-    std::cout << "Use ZLIB decoding? Enter 1 for yes, 0 for no: ";
+    std::cout << "Use GZIP/ZLIB decoding? Enter 1 for yes, 0 for no: ";
     std::cin >> useCompression;
 
 
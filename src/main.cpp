@@ -23,6 +23,10 @@
 #define _CRT_SECURE_NO_WARNINGS
 #define IMGUI_DISABLE_OBSOLETE_FUNCTIONS 1
 
+#define GLFW_INCLUDE_NONE
+#include "glad/gl.h"
+#include "GLFW/glfw3.h"
+
 #include "imgui/imgui.h"
 #include "stb_image.h"
 #include "implot/implot.h"
@@ -35,6 +39,7 @@
 #include "robot.h"
 #include "volcano.h"
 #include "robot_arm.h"
+#include "lidar_sensor.h"
 
 #include <algorithm>
 #include <stdio.h>
@@ -415,6 +420,19 @@ static void MouseButtonCallback(GLFWwindow* window, int32 button, int32 action,
 			s_application->MouseUp(pw);
 		}
 	}
+	else if (button == GLFW_MOUSE_BUTTON_MIDDLE)
+	{
+		b2Vec2 pw = g_camera.ConvertScreenToWorld(ps);
+		if (action == GLFW_PRESS)
+		{
+			s_application->MiddleMouseDown(pw);
+		}
+
+		if (action == GLFW_RELEASE)
+		{
+			s_application->MiddleMouseUp(pw);
+		}
+	}
 	else if (button == GLFW_MOUSE_BUTTON_2)
 	{
 		if (action == GLFW_PRESS)
@@ -558,6 +576,10 @@ static void UpdateUI()
                                 ImGui::RadioButton("None", Mqtt::getInstance().getCompressionInt(), 0); ImGui::SameLine();
                                 ImGui::RadioButton("GZip", Mqtt::getInstance().getCompressionInt(), 1); ImGui::SameLine();
                                 ImGui::RadioButton("ZLib", Mqtt::getInstance().getCompressionInt(), 2); ImGui::SameLine();
+                                ImGui::RadioButton("ZLib + dictionary", Mqtt::getInstance().getCompressionInt(), 3);
+                                if (*Mqtt::getInstance().getCompressionInt() != 0) {
+                                    ImGui::Text("Compression level: %d", Mqtt::getInstance().getCompressionLevel());
+                                }
 
                                 ImGui::Separator();
                                 ImGui::Separator();
@@ -581,11 +603,11 @@ static void UpdateUI()
                                 ImGui::PopID();
                                 ImGui::Separator();
                                 ImGui::Text("Amount of received kilobytes (total):");
-                                ImGui::Text("%f", (float)Mqtt::getInstance().receivedBytesTotal/1000.f);
+                                ImGui::Text("%f", (float)Mqtt::getInstance().receivedBytesTotal.load()/1000.f);
                                 ImGui::Text("Amount of received messages (total):");
-                                ImGui::Text("%d", Mqtt::getInstance().receivedMessages);
+                                ImGui::Text("%d", Mqtt::getInstance().receivedMessages.load());
                                 ImGui::Text("Currently receiving (kilobytes/sec):");
-                                ImGui::Text("%f", (float)Mqtt::getInstance().receivedBytesLastSecond/1000.f);
+                                ImGui::Text("%f", (float)Mqtt::getInstance().receivedBytesLastSecond.load()/1000.f);
 
                                 ImGui::Separator();
                                 ImGui::Checkbox("Print sending msgs?", &Mqtt::getInstance().printSendingMsgs);
@@ -754,6 +776,7 @@ static void UpdateUI()
                                 }
 
                                 ImGui::Checkbox("Show Battery Graph", &showBatteryGraph);
+                                ImGui::Checkbox("Visualize Lidar Every Frame", &LidarSensor::visualizeEveryFrame);
 
                                 ImGui::EndTabItem();
                         }
@@ -769,6 +792,20 @@ static void UpdateUI()
                                     RestartSimulation(initJsonFilePath);
                                 }
 
+                                ImGui::Separator();
+
+                                ImGui::SliderFloat("Time Scale", &s_settings.m_timeScale, 0.25f, 16.0f, "%.2fx");
+                                ImGui::Checkbox("Unthrottled (as fast as possible)", &s_settings.m_unthrottled);
+                                ImGui::Text("Simulated time: %.1f s", dynamic_cast<Simulation*>(s_application)->GetSimulationTime());
+
+                                auto arenaStats = dynamic_cast<Simulation*>(s_application)->GetArenaStats();
+                                ImGui::Text("Arena: %.1f / %.1f MB, %zu allocations, %zu frees",
+                                            arenaStats.bytesInUse / (1024.0 * 1024.0),
+                                            arenaStats.bytesReserved / (1024.0 * 1024.0), arenaStats.allocations,
+                                            arenaStats.frees);
+
+                                ImGui::Separator();
+
                                 static float epiX{};
                                 static float epiY{};
 
@@ -933,8 +970,8 @@ int main(int, char**)
         glfwSetWindowIcon(g_mainWindow, 1, images);
         stbi_image_free(images[0].pixels);
 
-        Simulation::window = g_mainWindow;
-        Simulation::camera = &g_camera;
+        // Draw the lidar every frame in the visual debugger, the headless simulator only scans when publishing
+        LidarSensor::visualizeEveryFrame = true;
 
         s_application = Simulation::Create(initJsonFilePath);
         Mqtt::getInstance().setSimulationPtr(dynamic_cast<Simulation *>(s_application));
@@ -981,8 +1018,7 @@ int main(int, char**)
 
 		s_application->Step(s_settings);
 
-                auto sim = dynamic_cast<Simulation*>(s_application);
-                Mqtt::getInstance().processMqtt(sim->GetStepCount());
+                Mqtt::getInstance().processMqtt();
 
 		UpdateUI();
 
@@ -1001,10 +1037,14 @@ int main(int, char**)
 
 		glfwPollEvents();
 
-		// Throttle to cap at 60Hz. This adaptive using a sleep adjustment. This could be improved by
-		// using mm_pause or equivalent for the last millisecond.
+		// Throttle to cap at the physics rate (60Hz by default) scaled by the time scale. This adaptive using a
+		// sleep adjustment. This could be improved by using mm_pause or equivalent for the last millisecond.
 		std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
-		std::chrono::duration<double> target(1.0 / 60.0);
+		std::chrono::duration<double> target(0.0);
+		if (!s_settings.m_unthrottled && s_settings.m_hertz > 0.0f && s_settings.m_timeScale > 0.0f)
+		{
+			target = std::chrono::duration<double>(1.0 / (s_settings.m_hertz * s_settings.m_timeScale));
+		}
 		std::chrono::duration<double> timeUsed = t2 - t1;
 		std::chrono::duration<double> sleepTime = target - timeUsed + sleepAdjust;
 		if (sleepTime > std::chrono::duration<double>(0))
@@ -0,0 +1,151 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Checks that MessageWriter writes the bytes nlohmann::json would. Runs the simulation with the robot driving and
+// takes every message the objects publish, switching between JSON and MessagePack every few steps. Each message is
+// decoded and encoded again with dump() or to_msgpack(), which have to give back the same bytes.
+
+#include "framework/settings.h"
+#include "mqtt.h"
+#include "simulation.h"
+
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace {
+
+struct TypeCount
+{
+    size_t json{0};
+    size_t messagePack{0};
+    size_t mismatches{0};
+};
+
+void
+PrintUsage()
+{
+    std::cout << "Usage: message_check [options]\n"
+                 "  --init <file>             Init json file (default: data/mission1.json, which has every kind of sensor)\n"
+                 "  --steps <n>               Simulation steps to check (default: 1200)\n"
+              << std::endl;
+}
+
+// Topics written with MessageWriter, queued without a broker so that the messages are written at all
+constexpr const char *checkedTopics[] = {
+    "out/general", "out/robotpos", "out/arm", "out/sensors", "out/sensors/lidar", "out/world"};
+
+} // namespace
+
+int
+main(int argc, char **argv)
+{
+    std::string initJsonFilePath{"data/mission1.json"};
+    long long steps{1200};
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--init") == 0 && i + 1 < argc) {
+            initJsonFilePath = argv[++i];
+        } else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            steps = std::stoll(argv[++i]);
+        } else {
+            PrintUsage();
+            return strcmp(argv[i], "--help") == 0 ? 0 : -1;
+        }
+    }
+
+    Settings settings;
+    settings.m_drawShapes = false;
+    settings.m_drawJoints = false;
+
+    auto &mqtt = Mqtt::getInstance();
+    mqtt.printSendingMsgs = false;
+
+    Simulation *simulation = Simulation::Create(initJsonFilePath);
+    mqtt.setSimulationPtr(simulation);
+
+    for (auto topic : checkedTopics) {
+        auto setting = mqtt.getTopicSetting(topic);
+        setting.waitForMQTTConnection = true;
+        mqtt.overrideTopicSettings(topic, setting);
+    }
+
+    std::map<std::string, TypeCount> counts;
+    size_t mismatches = 0;
+    mqtt.setMessageObserver([&](std::string_view topic, std::string_view message, MessageWriter::Format format) {
+        const bool messagePack = format == MessageWriter::Format::MessagePack;
+        nlohmann::json decoded = messagePack ? nlohmann::json::from_msgpack(message) : nlohmann::json::parse(message);
+
+        std::string expected;
+        if (messagePack) {
+            nlohmann::json::to_msgpack(decoded, expected);
+        } else {
+            expected = decoded.dump();
+        }
+
+        auto &count = counts[std::string{topic} + " " + decoded["type"].get<std::string>()];
+        (messagePack ? count.messagePack : count.json)++;
+        if (expected == message) {
+            return;
+        }
+
+        count.mismatches++;
+        if (mismatches++ == 0) {
+            std::cout << "First mismatch on " << topic << (messagePack ? ", MessagePack" : ", JSON") << ":\n"
+                      << "  written:  " << (messagePack ? nlohmann::json::from_msgpack(message).dump() : message)
+                      << "\n  expected: " << decoded.dump() << std::endl;
+        }
+    });
+
+    // Driving in a curve moves the robot and the stones it pushes, so the change based messages keep coming
+    simulation->Keyboard('W');
+    simulation->Keyboard('E');
+
+    while (simulation->GetStepCount() < steps) {
+        Settings::m_useMessagePackSend = simulation->GetStepCount() / 7 % 2 == 1;
+        simulation->Step(settings);
+        mqtt.processMqtt();
+
+        if (simulation->GetStepCount() == steps / 2) {
+            simulation->KeyboardUp('E');
+        }
+    }
+
+    mqtt.setMessageObserver({});
+
+    for (auto &&[type, count] : counts) {
+        std::cout << type << ": " << count.json << " JSON, " << count.messagePack << " MessagePack, "
+                  << count.mismatches << " mismatched" << std::endl;
+    }
+
+    if (counts.empty()) {
+        std::cout << "No messages were written." << std::endl;
+        return 1;
+    }
+
+    std::cout << (mismatches ? "FAILED, " : "OK, ") << mismatches << " mismatched messages" << std::endl;
+
+    delete simulation;
+
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,420 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "message_writer.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+void
+MessageWriter::reset(std::string *buffer, Format format)
+{
+    this->buffer = buffer;
+    this->format = format;
+    depth = 0;
+    hasValue[0] = false;
+    afterKey = false;
+}
+
+MessageWriter::Format
+MessageWriter::getFormat() const
+{
+    return format;
+}
+
+void
+MessageWriter::beginValue()
+{
+    if (format != Format::Json) {
+        return;
+    }
+
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+
+    if (hasValue[depth]) {
+        buffer->push_back(',');
+    }
+    hasValue[depth] = true;
+}
+
+void
+MessageWriter::beginObject(size_t members)
+{
+    beginValue();
+    if (format == Format::Json) {
+        buffer->push_back('{');
+        hasValue[++depth] = false;
+    } else if (members <= 15) {
+        buffer->push_back(static_cast<char>(0x80 | members));
+    } else if (members <= std::numeric_limits<uint16_t>::max()) {
+        writeBigEndian(0xDE, static_cast<uint16_t>(members));
+    } else {
+        writeBigEndian(0xDF, static_cast<uint32_t>(members));
+    }
+}
+
+void
+MessageWriter::endObject()
+{
+    if (format == Format::Json) {
+        buffer->push_back('}');
+        depth--;
+    }
+}
+
+void
+MessageWriter::beginArray(size_t elements)
+{
+    beginValue();
+    if (format == Format::Json) {
+        buffer->push_back('[');
+        hasValue[++depth] = false;
+    } else if (elements <= 15) {
+        buffer->push_back(static_cast<char>(0x90 | elements));
+    } else if (elements <= std::numeric_limits<uint16_t>::max()) {
+        writeBigEndian(0xDC, static_cast<uint16_t>(elements));
+    } else {
+        writeBigEndian(0xDD, static_cast<uint32_t>(elements));
+    }
+}
+
+void
+MessageWriter::endArray()
+{
+    if (format == Format::Json) {
+        buffer->push_back(']');
+        depth--;
+    }
+}
+
+void
+MessageWriter::key(std::string_view key)
+{
+    beginValue();
+    writeString(key);
+    if (format == Format::Json) {
+        buffer->push_back(':');
+        afterKey = true;
+    }
+}
+
+void
+MessageWriter::value(double number)
+{
+    beginValue();
+    if (format == Format::Json) {
+        if (!std::isfinite(number)) {
+            buffer->append("null", 4);
+            return;
+        }
+        char digits[64];
+        char *end = nlohmann::detail::to_chars(digits, digits + sizeof(digits), number);
+        buffer->append(digits, end - digits);
+        return;
+    }
+
+    // Same as nlohmann::json, single precision when nothing is lost
+    if (number >= std::numeric_limits<float>::lowest() && number <= std::numeric_limits<float>::max() &&
+        static_cast<double>(static_cast<float>(number)) == number) {
+        uint32_t bits;
+        const float single = static_cast<float>(number);
+        std::memcpy(&bits, &single, sizeof(bits));
+        writeBigEndian(0xCA, bits);
+    } else {
+        uint64_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        writeBigEndian(0xCB, bits);
+    }
+}
+
+void
+MessageWriter::value(bool boolean)
+{
+    beginValue();
+    if (format == Format::Json) {
+        if (boolean) {
+            buffer->append("true", 4);
+        } else {
+            buffer->append("false", 5);
+        }
+    } else {
+        buffer->push_back(static_cast<char>(boolean ? 0xC3 : 0xC2));
+    }
+}
+
+void
+MessageWriter::value(std::string_view string)
+{
+    beginValue();
+    writeString(string);
+}
+
+void
+MessageWriter::value(const char *string)
+{
+    value(std::string_view{string});
+}
+
+void
+MessageWriter::value(const std::string &string)
+{
+    value(std::string_view{string});
+}
+
+void
+MessageWriter::value(const nlohmann::json &json)
+{
+    switch (json.type()) {
+    case nlohmann::json::value_t::object:
+        beginObject(json.size());
+        for (auto it = json.begin(); it != json.end(); ++it) {
+            key(it.key());
+            value(it.value());
+        }
+        endObject();
+        break;
+    case nlohmann::json::value_t::array:
+        beginArray(json.size());
+        for (const auto &element : json) {
+            value(element);
+        }
+        endArray();
+        break;
+    case nlohmann::json::value_t::string:
+        value(json.get_ref<const std::string &>());
+        break;
+    case nlohmann::json::value_t::boolean:
+        value(json.get<bool>());
+        break;
+    case nlohmann::json::value_t::number_integer:
+        value(json.get<int64_t>());
+        break;
+    case nlohmann::json::value_t::number_unsigned:
+        value(json.get<uint64_t>());
+        break;
+    case nlohmann::json::value_t::number_float:
+        value(json.get<double>());
+        break;
+    default:
+        // Binary values are never sent
+        null();
+        break;
+    }
+}
+
+void
+MessageWriter::null()
+{
+    beginValue();
+    if (format == Format::Json) {
+        buffer->append("null", 4);
+    } else {
+        buffer->push_back(static_cast<char>(0xC0));
+    }
+}
+
+void
+MessageWriter::binary(std::string_view bytes)
+{
+    beginValue();
+    if (format == Format::MessagePack) {
+        const size_t length = bytes.size();
+        if (length <= std::numeric_limits<uint8_t>::max()) {
+            writeBigEndian(0xC4, static_cast<uint8_t>(length));
+        } else if (length <= std::numeric_limits<uint16_t>::max()) {
+            writeBigEndian(0xC5, static_cast<uint16_t>(length));
+        } else {
+            writeBigEndian(0xC6, static_cast<uint32_t>(length));
+        }
+        buffer->append(bytes);
+        return;
+    }
+
+    static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    buffer->push_back('"');
+    size_t i = 0;
+    for (; i + 3 <= bytes.size(); i += 3) {
+        const uint32_t bits = static_cast<uint8_t>(bytes[i]) << 16 | static_cast<uint8_t>(bytes[i + 1]) << 8 |
+                              static_cast<uint8_t>(bytes[i + 2]);
+        const char encoded[] = {alphabet[bits >> 18], alphabet[(bits >> 12) & 0x3F], alphabet[(bits >> 6) & 0x3F],
+                                alphabet[bits & 0x3F]};
+        buffer->append(encoded, 4);
+    }
+    if (i + 1 == bytes.size()) {
+        const uint32_t bits = static_cast<uint8_t>(bytes[i]) << 16;
+        const char encoded[] = {alphabet[bits >> 18], alphabet[(bits >> 12) & 0x3F], '=', '='};
+        buffer->append(encoded, 4);
+    } else if (i + 2 == bytes.size()) {
+        const uint32_t bits = static_cast<uint8_t>(bytes[i]) << 16 | static_cast<uint8_t>(bytes[i + 1]) << 8;
+        const char encoded[] = {alphabet[bits >> 18], alphabet[(bits >> 12) & 0x3F], alphabet[(bits >> 6) & 0x3F], '='};
+        buffer->append(encoded, 4);
+    }
+    buffer->push_back('"');
+}
+
+void
+MessageWriter::encodedValues(std::string_view encoded, size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    beginValue();
+    buffer->append(encoded);
+}
+
+void
+MessageWriter::position(float x, float y)
+{
+    beginObject(2);
+    key("x");
+    value(x);
+    key("y");
+    value(y);
+    endObject();
+}
+
+void
+MessageWriter::pose(float x, float y, float r)
+{
+    beginObject(3);
+    key("r");
+    value(r);
+    key("x");
+    value(x);
+    key("y");
+    value(y);
+    endObject();
+}
+
+void
+MessageWriter::writeUnsigned(uint64_t number)
+{
+    beginValue();
+    if (format == Format::Json) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), number);
+        buffer->append(digits, result.ptr - digits);
+    } else if (number < 128) {
+        buffer->push_back(static_cast<char>(number));
+    } else if (number <= std::numeric_limits<uint8_t>::max()) {
+        writeBigEndian(0xCC, static_cast<uint8_t>(number));
+    } else if (number <= std::numeric_limits<uint16_t>::max()) {
+        writeBigEndian(0xCD, static_cast<uint16_t>(number));
+    } else if (number <= std::numeric_limits<uint32_t>::max()) {
+        writeBigEndian(0xCE, static_cast<uint32_t>(number));
+    } else {
+        writeBigEndian(0xCF, number);
+    }
+}
+
+void
+MessageWriter::writeSigned(int64_t number)
+{
+    beginValue();
+    if (format == Format::Json) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), number);
+        buffer->append(digits, result.ptr - digits);
+    } else if (number >= -32) {
+        buffer->push_back(static_cast<char>(number));
+    } else if (number >= std::numeric_limits<int8_t>::min()) {
+        writeBigEndian(0xD0, static_cast<uint8_t>(number));
+    } else if (number >= std::numeric_limits<int16_t>::min()) {
+        writeBigEndian(0xD1, static_cast<uint16_t>(number));
+    } else if (number >= std::numeric_limits<int32_t>::min()) {
+        writeBigEndian(0xD2, static_cast<uint32_t>(number));
+    } else {
+        writeBigEndian(0xD3, static_cast<uint64_t>(number));
+    }
+}
+
+void
+MessageWriter::writeString(std::string_view string)
+{
+    if (format == Format::MessagePack) {
+        const size_t length = string.size();
+        if (length <= 31) {
+            buffer->push_back(static_cast<char>(0xA0 | length));
+        } else if (length <= std::numeric_limits<uint8_t>::max()) {
+            writeBigEndian(0xD9, static_cast<uint8_t>(length));
+        } else if (length <= std::numeric_limits<uint16_t>::max()) {
+            writeBigEndian(0xDA, static_cast<uint16_t>(length));
+        } else {
+            writeBigEndian(0xDB, static_cast<uint32_t>(length));
+        }
+        buffer->append(string);
+        return;
+    }
+
+    // Escapes like dump() without ensure_ascii
+    buffer->push_back('"');
+    for (char c : string) {
+        switch (c) {
+        case '"':
+            buffer->append("\\\"", 2);
+            break;
+        case '\\':
+            buffer->append("\\\\", 2);
+            break;
+        case '\b':
+            buffer->append("\\b", 2);
+            break;
+        case '\f':
+            buffer->append("\\f", 2);
+            break;
+        case '\n':
+            buffer->append("\\n", 2);
+            break;
+        case '\r':
+            buffer->append("\\r", 2);
+            break;
+        case '\t':
+            buffer->append("\\t", 2);
+            break;
+        default:
+            if (static_cast<unsigned char>(c) <= 0x1F) {
+                static constexpr char hex[] = "0123456789abcdef";
+                const char escaped[] = {'\\', 'u', '0', '0', hex[(c >> 4) & 0xF], hex[c & 0xF]};
+                buffer->append(escaped, sizeof(escaped));
+            } else {
+                buffer->push_back(c);
+            }
+            break;
+        }
+    }
+    buffer->push_back('"');
+}
+
+template <typename T>
+void
+MessageWriter::writeBigEndian(uint8_t type, T number)
+{
+    buffer->push_back(static_cast<char>(type));
+    for (int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8) {
+        buffer->push_back(static_cast<char>(static_cast<uint64_t>(number) >> shift));
+    }
+}
@@ -0,0 +1,125 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_MESSAGE_WRITER_H
+#define MARSIM_MESSAGE_WRITER_H
+
+#include "json.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Serializes JSON or MessagePack straight into a byte buffer, without building a nlohmann::json first. The output is
+// byte for byte what dump() or to_msgpack() produce for the same values. Since nlohmann::json keeps object keys
+// sorted, keys have to be written in sorted order, and MessagePack needs the member and element counts up front.
+// The message_check tool verifies this for the messages the simulation publishes.
+class MessageWriter
+{
+public:
+    enum class Format {
+        Json,
+        MessagePack
+    };
+
+    // Appends to the buffer, which is not cleared
+    void reset(std::string *buffer, Format format);
+
+    Format getFormat() const;
+
+    void beginObject(size_t members);
+
+    void endObject();
+
+    void beginArray(size_t elements);
+
+    void endArray();
+
+    void key(std::string_view key);
+
+    // Floats are written as the double they convert to, the same as nlohmann::json stores them
+    void value(double number);
+
+    void value(bool boolean);
+
+    void value(std::string_view string);
+
+    void value(const char *string);
+
+    void value(const std::string &string);
+
+    // Writes the DOM, for payloads that are not worth writing by hand
+    void value(const nlohmann::json &json);
+
+    template <typename Integer, std::enable_if_t<std::is_integral_v<Integer>, int> = 0>
+    void
+    value(Integer number)
+    {
+        if constexpr (std::is_signed_v<Integer>) {
+            if (number < 0) {
+                writeSigned(number);
+                return;
+            }
+        }
+        writeUnsigned(static_cast<uint64_t>(number));
+    }
+
+    void null();
+
+    // Bytes as MessagePack bin, or as a base64 string in JSON
+    void binary(std::string_view bytes);
+
+    // Appends values that were already encoded in the same format, count is how many there are
+    void encodedValues(std::string_view encoded, size_t count);
+
+    // {"x": x, "y": y}
+    void position(float x, float y);
+
+    // {"r": r, "x": x, "y": y}
+    void pose(float x, float y, float r);
+
+private:
+    // Writes the separator in front of a value in JSON
+    void beginValue();
+
+    void writeUnsigned(uint64_t number);
+
+    void writeSigned(int64_t number);
+
+    void writeString(std::string_view string);
+
+    // MessagePack type byte followed by the big endian value
+    template <typename T>
+    void writeBigEndian(uint8_t type, T number);
+
+    std::string *buffer{};
+    Format format{Format::Json};
+
+    // Whether the container at each depth has a value already and needs a comma before the next
+    static constexpr int maxDepth = 32;
+    bool hasValue[maxDepth]{};
+    int depth{0};
+    bool afterKey{false};
+};
+
+#endif // MARSIM_MESSAGE_WRITER_H
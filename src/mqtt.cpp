@@ -27,107 +27,45 @@
 #include "robot_arm.h"
 #include "simulation.h"
 #include <chrono>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
 #include <json.hpp>
-#include <zlc/zlibcomplete.hpp>
 
+#include <iterator>
+
+namespace {
+
+using CommandHandler = void (*)(const Command &);
+
+// Indexed by CommandType
+constexpr CommandHandler commandHandlers[] = {
+    nullptr,
+    &Mqtt::receiveMsgMotors,
+    &Mqtt::receiveMsgPickup,
+    &Mqtt::receiveMsgDrop,
+    &Mqtt::receiveMsgLaserShoot,
+    &Mqtt::receiveMsgLaserAngle,
+    &Mqtt::receiveMsgRequestImage,
+    &Mqtt::receiveMsgRequestImageBlurred,
+    &Mqtt::receiveMsgRobotArm,
+    &Mqtt::receiveMsgRobotArm_Close,
+    &Mqtt::receiveMsgRobotArm_Open,
+    &Mqtt::receiveMsgRobotArm_Lock,
+    &Mqtt::receiveMsgRobotArm_UnLock,
+    &Mqtt::receiveMsgRobotLockBase,
+    &Mqtt::receiveMsgRobotUnLockBase,
+};
+static_assert(std::size(commandHandlers) == static_cast<size_t>(CommandType::Count));
+
+} // namespace
+
+// Runs on the I/O thread, only decodes the message and queues it for the simulation thread
 void
 on_message(struct mosquitto *mosq, void *userdata, const struct mosquitto_message *message)
 {
-    Mqtt::getInstance().receivedMessages++;
-    Mqtt::getInstance().receivedBytesTotal += message->payloadlen;
-    Mqtt::getInstance().receivedBytesSecond += message->payloadlen;
-
-    if (Mqtt::getInstance().printReceivingMsgs) {
-        printf("Received MQTT message topic(%s): %s\n", message->topic, (char *)message->payload);
-    }
-
-    if (message->payloadlen) {
-        if (strcmp(message->topic, std::string{Mqtt::getSimIdPrefix() + "in/image"}.c_str()) == 0) {
-            std::ofstream image_file("data/lunar_received.png", std::ios::binary);
-            image_file.write(reinterpret_cast<const char *>(message->payload), message->payloadlen);
-            image_file.close();
-
-            std::cout << "Image received and saved as data/lunar_received.png\nRegenerating blurred terrain."
-                      << std::endl;
-            Mqtt::getInstance().simulation->GenerateBlurredTerrain();
-        } else if (strcmp(message->topic, std::string{Mqtt::getSimIdPrefix() + "in/control"}.c_str()) == 0) {
-            std::string payloadStr((char *)message->payload, message->payloadlen);
-
-            int receiveCompression = *Mqtt::getInstance().getCompressionReceiveInt();
-
-            // Decompress
-            if (receiveCompression == 1) {
-                zlibcomplete::GZipDecompressor gZipDecompressor;
-                payloadStr = gZipDecompressor.decompress(payloadStr);
-            } else if (receiveCompression == 2) {
-                zlibcomplete::ZLibDecompressor zLibDecompressor{};
-                payloadStr = zLibDecompressor.decompress(payloadStr);
-            }
-
-            try {
-                bool receiveMsgPack = *Mqtt::getInstance().useMessagePackReceiveBool();
-
-                nlohmann::json j;
-                if (receiveMsgPack) {
-                    j = nlohmann::json::from_msgpack(payloadStr);
-                } else {
-                    j = nlohmann::json::parse(payloadStr);
-                }
-
-                std::string type = j["type"];
-                nlohmann::json jsonPayload = j["data"];
-
-                if (type == "motors") {
-                    Mqtt::receiveMsgMotors(jsonPayload);
-                } else if (type == "pickup") {
-                    Mqtt::receiveMsgPickup(jsonPayload);
-                } else if (type == "drop") {
-                    Mqtt::receiveMsgDrop(jsonPayload);
-                } else if (type == "shoot_laser") {
-                    Mqtt::receiveMsgLaserShoot(jsonPayload);
-                } else if (type == "laser_angle") {
-                    Mqtt::receiveMsgLaserAngle(jsonPayload);
-                } else if (type == "request_satellite_image") {
-                    Mqtt::receiveMsgRequestImage(jsonPayload);
-                } else if (type == "request_satellite_image_blurred") {
-                    Mqtt::receiveMsgRequestImageBlurred(jsonPayload);
-                }else if (type == "arm_speeds") {
-                    Mqtt::receiveMsgRobotArm(jsonPayload);
-                } else if (type == "arm_close") {
-                    Mqtt::receiveMsgRobotArm_Close(jsonPayload);
-                } else if (type == "arm_open") {
-                    Mqtt::receiveMsgRobotArm_Open(jsonPayload);
-                } else if (type == "arm_fold_lock") {
-                    Mqtt::receiveMsgRobotArm_Lock(jsonPayload);
-                } else if (type == "arm_fold_unlock") {
-                    Mqtt::receiveMsgRobotArm_UnLock(jsonPayload);
-                } else if (type == "robot_lock_base") {
-                    Mqtt::receiveMsgRobotLockBase(jsonPayload);
-                } else if (type == "robot_unlock_base") {
-                    Mqtt::receiveMsgRobotUnLockBase(jsonPayload);
-                }
-
-            } catch (std::exception e) {
-                std::cerr << "Something went wrong trying to interpret message: " << e.what() << std::endl;
-                std::cerr << "Refer to the simulation documentation for messages." << std::endl;
-                std::cerr << "Alternatively, look at the source code for simulator receiving messages "
-                             "at:\nhttps://github.com/mormert/marsim/blob/main/src/mqtt.cpp"
-                          << std::endl;
-            }
-        } else {
-            std::cerr << "WARNING: something went wrong trying to receive MQTT message" << std::endl;
-            std::cerr << "Refer to the simulation documentation for messages." << std::endl;
-            std::cerr << "Alternatively, look at the source code for simulator receiving messages "
-                         "at:\nhttps://github.com/mormert/marsim/blob/main/src/mqtt.cpp"
-                      << std::endl;
-        }
-    } else {
-        printf("%s (null)\n", message->topic);
-    }
-    fflush(stdout);
+    Mqtt::getInstance().receiveMqtt(message);
 }
 
 // shows if connected correctly
@@ -151,152 +89,510 @@ my_log_callback(struct mosquitto *mosq, void *userdata, int level, const char *s
 
 Mqtt::Mqtt() { init(); }
 
-Mqtt::~Mqtt() { cleanup(); }
-
 void
-Mqtt::connectMqtt(const std::string &address, int port)
+Mqtt::receiveMqtt(const mosquitto_message *message)
 {
+    receivedMessages++;
+    receivedBytesTotal += message->payloadlen;
+    receivedBytesSecond += message->payloadlen;
 
-    mosquitto_reinitialise(mqtt, std::string{"Simulator_Channel" + std::to_string(mqttInstanceId)}.c_str(), true, NULL);
-    setupMqtt();
+    if (printReceiving) {
+        printf("Received MQTT message topic(%s): %s\n", message->topic, (char *)message->payload);
+        fflush(stdout);
+    }
 
-    mosquitto_username_pw_set(mqtt, std::string{"simtor" + std::to_string(mqttInstanceId)}.c_str(), "simtor23");
+    if (!message->payloadlen) {
+        printf("%s (null)\n", message->topic);
+        fflush(stdout);
+        return;
+    }
 
-    auto rc = mosquitto_connect(mqtt, address.c_str(), port, 60);
+    if (controlTopic == message->topic) {
+        const char *payload = static_cast<const char *>(message->payload);
+        size_t size = message->payloadlen;
 
-    // Set isConnected bool to true IF we connected successfully
-    if (rc != MOSQ_ERR_SUCCESS) {
-        is_connected = false;
-        std::cout << "could not connect!" << std::endl;
-    } else {
-        if (mosquitto_subscribe(mqtt, NULL, std::string{getSimIdPrefix() + "in/control"}.c_str(), 1) !=
-            MOSQ_ERR_SUCCESS) {
-            std::cerr << "Failed to subscribe!" << std::endl;
+        if (receiveCompression != CompressionNone) {
+            if (!decompressor.decompress({payload, size}, inflated)) {
+                std::cerr << "Failed to decompress a received message." << std::endl;
+                return;
+            }
+            payload = inflated.data();
+            size = inflated.size();
+        }
+
+        InboundMessage inboundMessage;
+        if (!commandParser.parse(payload, size, receiveMessagePack, inboundMessage.command)) {
+            std::cerr << "Something went wrong trying to interpret message: " << commandParser.error() << std::endl;
+            std::cerr << "Refer to the simulation documentation for messages." << std::endl;
+            std::cerr << "Alternatively, look at the source code for simulator receiving messages "
+                         "at:\nhttps://github.com/mormert/marsim/blob/main/src/mqtt.cpp"
+                      << std::endl;
+            return;
+        }
+
+        // Messages of unknown types have never done anything
+        if (inboundMessage.command.type == CommandType::Unknown) {
+            return;
         }
-        if (mosquitto_subscribe(mqtt, NULL, std::string{getSimIdPrefix() + "in/image"}.c_str(), 1) !=
-            MOSQ_ERR_SUCCESS) {
-            std::cerr << "Failed to subscribe!" << std::endl;
+
+        if (!queueInbound(std::move(inboundMessage))) {
+            std::cerr << "Dropped a control message, the simulation is not keeping up." << std::endl;
+        }
+    } else if (imageTopic == message->topic) {
+        auto payload = static_cast<const unsigned char *>(message->payload);
+
+        InboundMessage inboundMessage;
+        inboundMessage.isImage = true;
+        inboundMessage.image.assign(payload, payload + message->payloadlen);
+        if (!queueInbound(std::move(inboundMessage))) {
+            std::cerr << "Dropped a received image, the simulation is not keeping up." << std::endl;
         }
+    } else {
+        std::cerr << "WARNING: something went wrong trying to receive MQTT message" << std::endl;
+        std::cerr << "Refer to the simulation documentation for messages." << std::endl;
+        std::cerr << "Alternatively, look at the source code for simulator receiving messages "
+                     "at:\nhttps://github.com/mormert/marsim/blob/main/src/mqtt.cpp"
+                  << std::endl;
     }
 }
 
+Mqtt::~Mqtt() { cleanup(); }
+
+void
+Mqtt::connectMqtt(const std::string &address, int port)
+{
+    std::lock_guard<std::mutex> lock{connectionMutex};
+    connectRequested = true;
+    disconnectRequested = false;
+    connectAddress = address;
+    connectPort = port;
+}
+
 void
 Mqtt::disconnectMqtt()
 {
-    int err = mosquitto_disconnect(mqtt);
-    if (err == MOSQ_ERR_SUCCESS) {
-        is_connected = false;
+    std::lock_guard<std::mutex> lock{connectionMutex};
+    disconnectRequested = true;
+    connectRequested = false;
+}
 
-    } else {
-        std::cout << "Failed to disconnect! error code: ";
-        std::cout << err << std::endl;
+void
+Mqtt::handleConnectionRequests(bool &socketOpen)
+{
+    bool connect, disconnect;
+    std::string address;
+    int port;
+    {
+        std::lock_guard<std::mutex> lock{connectionMutex};
+        connect = connectRequested;
+        disconnect = disconnectRequested;
+        address = connectAddress;
+        port = connectPort;
+        connectRequested = disconnectRequested = false;
+    }
+
+    if (connect) {
+        mosquitto_reinitialise(
+            mqtt, std::string{"Simulator_Channel" + std::to_string(mqttInstanceId)}.c_str(), true, NULL);
+        setupMqtt();
+
+        mosquitto_username_pw_set(mqtt, std::string{"simtor" + std::to_string(mqttInstanceId)}.c_str(), "simtor23");
+
+        auto rc = mosquitto_connect(mqtt, address.c_str(), port, 60);
+
+        // isConnected turns true in on_connect, once the broker answered
+        if (rc != MOSQ_ERR_SUCCESS) {
+            is_connected = false;
+            socketOpen = false;
+            std::cout << "could not connect!" << std::endl;
+        } else {
+            socketOpen = true;
+            controlTopic = getSimIdPrefix() + "in/control";
+            imageTopic = getSimIdPrefix() + "in/image";
+            if (mosquitto_subscribe(mqtt, NULL, controlTopic.c_str(), 1) != MOSQ_ERR_SUCCESS) {
+                std::cerr << "Failed to subscribe!" << std::endl;
+            }
+            if (mosquitto_subscribe(mqtt, NULL, imageTopic.c_str(), 1) != MOSQ_ERR_SUCCESS) {
+                std::cerr << "Failed to subscribe!" << std::endl;
+            }
+        }
+    }
+
+    if (disconnect) {
+        int err = mosquitto_disconnect(mqtt);
+        if (err == MOSQ_ERR_SUCCESS) {
+            is_connected = false;
+        } else {
+            std::cout << "Failed to disconnect! error code: ";
+            std::cout << err << std::endl;
+        }
     }
 }
 
 void
 Mqtt::send(const std::string &topic, const std::string &message_type, const nlohmann::json &payload)
 {
-    TopicSetting topicSetting;
-    auto it = topicSettings.find(topic);
-    if (it != topicSettings.end()) {
-        topicSetting = it->second;
+    if (auto writer = beginMessage(topic, message_type)) {
+        writer->value(payload);
+        endMessage();
     }
+}
 
-    if (!is_connected && !topicSetting.waitForMQTTConnection) {
-        return;
+MessageWriter *
+Mqtt::beginMessage(std::string_view topic, std::string_view message_type, unsigned int objectId)
+{
+    auto &queue = getTopicQueue(topic);
+
+    if (!is_connected && !queue.setting.waitForMQTTConnection) {
+        return nullptr;
     }
 
-    nlohmann::json j;
-    j["type"] = message_type;
-    j["data"] = payload;
+    // A message that replaces a queued one never counts against the limit
+    uint64_t key = 0;
+    bool replaces = false;
+    if (queue.setting.latestValue) {
+        key = getLatestValueKey(queue, message_type, objectId);
+        replaces = queue.latest.count(key) != 0;
+    }
+    if (!replaces && queue.setting.maxMessages != -1 && queue.count >= static_cast<size_t>(queue.setting.maxMessages)) {
+        return nullptr;
+    }
 
-    auto &&vec = queuedMessages[topic];
-    if (topicSetting.maxMessages != -1) {
-        if (vec.size() < topicSetting.maxMessages) {
-            vec.push_back(j);
-        }
-    } else {
-        vec.push_back(j);
+    // Messages written before the format was switched would not fit in the same batch
+    const auto format = Settings::m_useMessagePackSend ? MessageWriter::Format::MessagePack
+                                                       : MessageWriter::Format::Json;
+    if (queue.format != format) {
+        queue.discarded += queue.count > 0;
+        queue.format = format;
+        queue.messages.clear();
+        queue.queued.clear();
+        queue.latest.clear();
+        queue.count = 0;
+        queue.replacedBytes = 0;
     }
+
+    if (queue.count == 0) {
+        queue.firstQueuedTime = getQueueTime();
+    }
+
+    queue.queued.push_back({queue.messages.size(), 0, key});
+
+    writer.reset(&queue.messages, format);
+    writer.beginObject(2);
+    writer.key("data");
+
+    openQueue = &queue;
+    openType = message_type;
+    openKey = key;
+    return &writer;
 }
 
 void
-Mqtt::processMqtt(int32_t step)
+Mqtt::endMessage()
 {
-    auto rc = mosquitto_loop(mqtt, 0, 1);
-    if (rc == MOSQ_ERR_NO_CONN && is_connected) {
-        std::cerr << "ERROR WITH MQTT, DISCONNECTED, LIKELY BECAUSE SOMEONE ELSE CONNECTED!" << std::endl;
-        is_connected = false;
-        mosquitto_reinitialise(
-            mqtt, std::string{"Simulator_Channel" + std::to_string(mqttInstanceId)}.c_str(), true, NULL);
-        setupMqtt();
+    writer.key("type");
+    writer.value(openType);
+    writer.endObject();
+
+    auto &queue = *openQueue;
+    auto &message = queue.queued.back();
+    message.size = queue.messages.size() - message.offset;
+    queue.count++;
+
+    if (messageObserver) {
+        messageObserver(queue.topic, std::string_view{queue.messages}.substr(message.offset, message.size), queue.format);
     }
 
-    if (!is_connected) {
-        return;
+    if (queue.setting.latestValue) {
+        auto [latest, inserted] = queue.latest.try_emplace(openKey, queue.queued.size() - 1);
+        if (!inserted) {
+            auto &older = queue.queued[latest->second];
+            queue.replacedBytes += older.size;
+            older.size = 0;
+            queue.count--;
+            latest->second = queue.queued.size() - 1;
+        }
+
+        // A topic held back for long keeps replacing its messages, the buffer should not grow with them
+        if (queue.replacedBytes > 4096 && queue.replacedBytes > queue.messages.size() / 2) {
+            compactTopicQueue(queue);
+        }
     }
 
-    if (step % 60 == 0) {
-        sentBytesLastSecond = sentBytesSecond;
-        sentBytesSecond = 0;
-        receivedBytesLastSecond = receivedBytesSecond;
-        receivedBytesSecond = 0;
+    openQueue = nullptr;
+}
+
+uint64_t
+Mqtt::getLatestValueKey(TopicQueue &queue, std::string_view messageType, unsigned int objectId)
+{
+    // A topic carries a handful of message types at most
+    size_t type = 0;
+    while (type < queue.types.size() && queue.types[type] != messageType) {
+        type++;
+    }
+    if (type == queue.types.size()) {
+        queue.types.emplace_back(messageType);
     }
 
-    // Note: removed "global send frequency"
-    // if (step % 3 == 0) {
-    sendQueuedMessages();
-    //}
+    return (static_cast<uint64_t>(type) << 32) | objectId;
 }
 
 void
-Mqtt::sendQueuedMessages()
+Mqtt::compactTopicQueue(TopicQueue &queue)
 {
-    const auto tp = std::chrono::system_clock::now();
+    size_t written = 0;
+    size_t kept = 0;
+    for (size_t i = 0; i < queue.queued.size(); i++) {
+        auto message = queue.queued[i];
+        if (!message.size) {
+            continue;
+        }
+        std::memmove(&queue.messages[written], &queue.messages[message.offset], message.size);
+        message.offset = written;
+        written += message.size;
+
+        // Messages queued before the topic was switched to latest value are not in the index
+        auto latest = queue.latest.find(message.key);
+        if (latest != queue.latest.end() && latest->second == i) {
+            latest->second = kept;
+        }
+        queue.queued[kept++] = message;
+    }
+    queue.messages.resize(written);
+    queue.queued.resize(kept);
+    queue.replacedBytes = 0;
+}
 
-    // Send all messages as a batch for each topic
-    for (auto &&[topic, msgs] : queuedMessages) {
+double
+Mqtt::getQueueTime() const
+{
+    return simulation ? simulation->GetSimulationTime() : 0.0;
+}
 
-        if (msgs.empty()) {
-            continue;
+Mqtt::TopicQueue &
+Mqtt::getTopicQueue(std::string_view topic)
+{
+    for (auto &queue : topicQueues) {
+        if (queue.topic == topic) {
+            return queue;
+        }
+    }
+
+    TopicQueue queue;
+    queue.topic = topic;
+    queue.publishTopic = getSimIdPrefix() + queue.topic;
+    auto it = topicSettings.find(queue.topic);
+    if (it != topicSettings.end()) {
+        queue.setting = it->second;
+    }
+    topicQueues.push_back(std::move(queue));
+    return topicQueues.back();
+}
+
+void
+Mqtt::processMqtt()
+{
+    // The I/O thread decodes received messages with the settings of the last frame
+    receiveCompression = Settings::m_compressionReceive;
+    receiveMessagePack = Settings::m_useMessagePackReceive;
+    printReceiving = printReceivingMsgs;
+
+    if (!is_connected) {
+        return;
+    }
+
+    sendQueuedMessages();
+}
+
+void
+Mqtt::ioLoop()
+{
+    bool socketOpen = false;
+
+    while (!stopIo) {
+        handleConnectionRequests(socketOpen);
+
+        int rc = MOSQ_ERR_NO_CONN;
+        if (socketOpen) {
+            // Waits on the socket for a moment, which also paces the loop
+            rc = mosquitto_loop(mqtt, 1, 1);
+            if (rc == MOSQ_ERR_NO_CONN) {
+                if (is_connected) {
+                    std::cerr << "ERROR WITH MQTT, DISCONNECTED, LIKELY BECAUSE SOMEONE ELSE CONNECTED!" << std::endl;
+                    is_connected = false;
+                    mosquitto_reinitialise(
+                        mqtt, std::string{"Simulator_Channel" + std::to_string(mqttInstanceId)}.c_str(), true, NULL);
+                    setupMqtt();
+                }
+                socketOpen = false;
+            }
         }
 
-        TopicSetting topicSetting;
-        auto it = topicSettings.find(topic);
-        if (it != topicSettings.end()) {
-            topicSetting = it->second;
+        if (rc != MOSQ_ERR_SUCCESS) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
         }
 
-        nlohmann::json j;
-        j["time"] = tp.time_since_epoch().count();
-        j["msgs"] = msgs;
+        // Messages queued while the connection was lost are dropped, the same as when sending while disconnected
+        OutboundMessage message;
+        while (outbound.pop(message)) {
+            if (is_connected) {
+                publishOutbound(message);
+            }
+            if (!message.isRaw) {
+                spentMessages.push(std::move(message));
+            }
+        }
 
-        std::string jsonString;
+        const auto now = std::chrono::steady_clock::now();
+        if (now - statsTimePoint >= std::chrono::seconds(1)) {
+            statsTimePoint = now;
+            sentBytesLastSecond = sentBytesSecond.exchange(0);
+            receivedBytesLastSecond = receivedBytesSecond.exchange(0);
+        }
+    }
+}
 
-        if (Settings::m_useMessagePackSend) {
-            auto msgPack = nlohmann::json::to_msgpack(j);
-            jsonString = std::string(msgPack.begin(), msgPack.end());
-        } else {
-            jsonString = j.dump();
+void
+Mqtt::sendQueuedMessages()
+{
+    // Follows the simulated time, which runs ahead of the wall clock when stepping faster than real-time
+    const auto tp = simulation ? simulation->GetSimulationTimePoint() : std::chrono::system_clock::now();
+    const double now = getQueueTime();
+
+    // Send all messages as a batch for each topic, the topics of higher priority first. Lower ones keep their messages
+    // while the I/O thread has a backlog, so it is spent on what matters most.
+    for (auto priority : {TopicPriority::High, TopicPriority::Normal, TopicPriority::Low}) {
+        const size_t backlog = outbound.size();
+        if ((priority == TopicPriority::Normal && backlog >= outboundCapacity / 2) ||
+            (priority == TopicPriority::Low && backlog >= outboundCapacity / 4)) {
+            break;
+        }
+
+        for (auto &queue : topicQueues) {
+            if (queue.setting.priority == priority && queue.count > 0 && isTopicDue(queue, now)) {
+                publishTopicQueue(queue, tp, now);
+            }
         }
+    }
+}
+
+bool
+Mqtt::isTopicDue(const TopicQueue &queue, double now) const
+{
+    // The simulated time starts over with a new simulation
+    if (now < queue.firstQueuedTime || (queue.published && now < queue.lastPublishTime)) {
+        return true;
+    }
+
+    if (now - queue.firstQueuedTime < queue.setting.coalesceWindow) {
+        return false;
+    }
+
+    return !queue.published || queue.setting.maxRate <= 0.f ||
+           now - queue.lastPublishTime >= 1.0 / queue.setting.maxRate;
+}
 
-        if (Settings::m_compressionSend == 1) {
-            zlibcomplete::GZipCompressor gZipCompressor(9, zlibcomplete::flush_parameter::auto_flush);
-            jsonString = gZipCompressor.compress(jsonString);
-            gZipCompressor.finish();
-        } else if (Settings::m_compressionSend == 2) {
-            zlibcomplete::ZLibCompressor zLibCompressor(9, zlibcomplete::flush_parameter::auto_flush);
-            jsonString = zLibCompressor.compress(jsonString);
-            zLibCompressor.finish();
+void
+Mqtt::publishTopicQueue(TopicQueue &queue, std::chrono::system_clock::time_point timePoint, double now)
+{
+    // Reuses the buffers of a batch the I/O thread is done with, if there is one
+    OutboundMessage message;
+    spentMessages.pop(message);
+
+    message.topic = queue.publishTopic;
+    message.data.clear();
+    writer.reset(&message.data, queue.format);
+    writer.beginObject(2);
+    writer.key("msgs");
+    writer.beginArray(queue.count);
+    for (auto &&queued : queue.queued) {
+        if (queued.size) {
+            writer.encodedValues(std::string_view{queue.messages}.substr(queued.offset, queued.size), 1);
         }
+    }
+    writer.endArray();
+    writer.key("time");
+    writer.value(timePoint.time_since_epoch().count());
+    writer.endObject();
+
+    message.isRaw = false;
+    message.retained = queue.setting.retained;
+    message.qos = 0;
+    message.compression = Settings::m_compressionSend;
+    message.messagePack = queue.format == MessageWriter::Format::MessagePack;
+    message.print = printSendingMsgs;
+    if (!queueOutbound(std::move(message))) {
+        queue.discarded++;
+    }
+
+    queue.messages.clear();
+    queue.queued.clear();
+    queue.latest.clear();
+    queue.count = 0;
+    queue.replacedBytes = 0;
+    queue.lastPublishTime = now;
+    queue.published = true;
+}
+
+void
+Mqtt::publishOutbound(OutboundMessage &message)
+{
+    if (message.isRaw || message.compression == CompressionNone) {
+        sendMqtt(message.topic, message.data, message.qos, message.retained, message.print);
+        return;
+    }
+
+    compressor.setCpuBudget(compressionCpuBudget);
+    if (!compressor.compress(message.data, message.compression, message.messagePack, compressed)) {
+        std::cerr << "Failed to compress a message for " << message.topic << std::endl;
+        return;
+    }
+    compressionLevel = compressor.getLevel();
+
+    sendMqtt(message.topic, compressed, message.qos, message.retained, message.print);
+}
+
+bool
+Mqtt::queueOutbound(OutboundMessage &&message)
+{
+    if (!outbound.push(std::move(message))) {
+        droppedMessages++;
+        return false;
+    }
+    return true;
+}
+
+void
+Mqtt::publishRaw(const std::string &topic, std::string data, int qos, bool retained)
+{
+    OutboundMessage message;
+    message.topic = topic;
+    message.data = std::move(data);
+    message.isRaw = true;
+    message.qos = qos;
+    message.retained = retained;
+    queueOutbound(std::move(message));
+}
+
+bool
+Mqtt::queueInbound(InboundMessage &&message)
+{
+    return inbound.push(std::move(message));
+}
 
-        if (is_connected) {
-            sendMqtt(getSimIdPrefix() + topic, jsonString, topicSetting.retained);
-            msgs.clear();
+void
+Mqtt::receiveQueuedMessages()
+{
+    InboundMessage message;
+    while (inbound.pop(message)) {
+        if (message.isImage) {
+            std::cout << "Image received, regenerating blurred terrain in the background." << std::endl;
+            simulation->RegenerateTerrainAsync(std::move(message.image));
+            continue;
         }
 
-        if (!topicSetting.waitForMQTTConnection) {
-            msgs.clear();
+        if (auto handler = commandHandlers[static_cast<size_t>(message.command.type)]) {
+            handler(message.command);
         }
     }
 }
@@ -308,12 +604,12 @@ Mqtt::isConnected()
 }
 
 void
-Mqtt::sendMqtt(const std::string &topic, const std::string &data, bool retained)
+Mqtt::sendMqtt(const std::string &topic, const std::string &data, int qos, bool retained, bool print)
 {
-    if (printSendingMsgs) {
+    if (print) {
         std::cout << "Sending topic(" << topic << ", retained: " << retained << "): " << data << std::endl;
     }
-    mosquitto_publish(mqtt, NULL, topic.c_str(), data.length(), data.c_str(), 0, retained);
+    mosquitto_publish(mqtt, NULL, topic.c_str(), data.length(), data.c_str(), qos, retained);
     sentBytesTotal += data.length();
     sentBytesSecond += data.length();
     sentMessages++;
@@ -325,6 +621,8 @@ Mqtt::init()
     mosquitto_lib_init();
     mqtt = mosquitto_new("Simulator_Channel0", true, NULL);
     setupMqtt();
+
+    ioThread = std::thread{[this] { ioLoop(); }};
 }
 
 void
@@ -348,6 +646,11 @@ Mqtt::setupMqtt()
 void
 Mqtt::cleanup()
 {
+    stopIo = true;
+    if (ioThread.joinable()) {
+        ioThread.join();
+    }
+
     mosquitto_destroy(mqtt);
     mosquitto_lib_cleanup();
 }
@@ -372,6 +675,16 @@ Mqtt::getEmissionSpeed()
 {
     return sentBytesLastSecond;
 }
+int
+Mqtt::getCompressionLevel()
+{
+    return compressionLevel;
+}
+void
+Mqtt::setCompressionCpuBudget(float budget)
+{
+    compressionCpuBudget = budget;
+}
 unsigned int
 Mqtt::getMessagesSent()
 {
@@ -379,62 +692,63 @@ Mqtt::getMessagesSent()
 }
 
 void
-Mqtt::receiveMsgPickup(const nlohmann::json &data)
+Mqtt::receiveMsgPickup(const Command &command)
 {
+    // An optional id picks up that object instead of the first one within reach
+    if (command.has(Command::Id)) {
+        Mqtt::getInstance().simulation->GetRobot()->pickup(command.id);
+        return;
+    }
+
     Mqtt::getInstance().simulation->GetRobot()->pickup();
 }
 
 void
-Mqtt::receiveMsgMotors(const nlohmann::json &data)
+Mqtt::receiveMsgMotors(const Command &command)
 {
-    try {
-        float left = data["left"];
-        float right = data["right"];
-        left = glm::clamp(left, -1.f, 1.f);
-        right = glm::clamp(right, -1.f, 1.f);
-
-        Mqtt::getInstance().simulation->GetRobot()->leftAccelerate = left;
-        Mqtt::getInstance().simulation->GetRobot()->rightAccelerate = right;
-    } catch (std::exception &e) {
-        std::cerr << "Failed to set motor speed: " << e.what() << std::endl;
+    if (!command.has(Command::Left | Command::Right)) {
+        std::cerr << "Failed to set motor speed: left and right have to be numbers" << std::endl;
+        return;
     }
+
+    Mqtt::getInstance().simulation->GetRobot()->leftAccelerate = glm::clamp(command.left, -1.f, 1.f);
+    Mqtt::getInstance().simulation->GetRobot()->rightAccelerate = glm::clamp(command.right, -1.f, 1.f);
 }
 
 void
-Mqtt::receiveMsgDrop(const nlohmann::json &data)
+Mqtt::receiveMsgDrop(const Command &command)
 {
-    try {
-        unsigned int itemIndex = data["index"];
+    if (!command.has(Command::Index)) {
+        std::cerr << "Failed to drop the specified item with an index: index has to be a number" << std::endl;
+        return;
+    }
 
-        if (!Mqtt::getInstance().simulation->GetRobot()->drop(itemIndex)) {
-            std::cerr << "Failed to drop item with index " << itemIndex << ", it does not exist in storage."
-                      << std::endl;
-        }
-    } catch (std::exception &e) {
-        std::cerr << "Failed to drop the specified item with an index: " << e.what() << std::endl;
+    if (!Mqtt::getInstance().simulation->GetRobot()->drop(command.index)) {
+        std::cerr << "Failed to drop item with index " << command.index << ", it does not exist in storage."
+                  << std::endl;
     }
 }
 
 void
-Mqtt::receiveMsgLaserAngle(const nlohmann::json &data)
+Mqtt::receiveMsgLaserAngle(const Command &command)
 {
-    try {
-        float deg = data["angle"];
-        Mqtt::getInstance().simulation->GetRobot()->setLaserAngleDegrees(deg);
-    } catch (std::exception &e) {
-        std::cerr << "Failed to set laser angle: " << e.what() << std::endl;
+    if (!command.has(Command::Angle)) {
+        std::cerr << "Failed to set laser angle: angle has to be a number" << std::endl;
+        return;
     }
+
+    Mqtt::getInstance().simulation->GetRobot()->setLaserAngleDegrees(command.angle);
 }
 
 void
-Mqtt::receiveMsgLaserShoot(const nlohmann::json &data)
+Mqtt::receiveMsgLaserShoot(const Command &command)
 {
     Mqtt::getInstance().simulation->GetRobot()->shootLaser();
     std::cout << "Firing laser..." << std::endl;
 }
 
 void
-Mqtt::receiveMsgRequestImage(const nlohmann::json &data)
+Mqtt::receiveMsgRequestImage(const Command &command)
 {
     std::ifstream image_file(requestImagePath.c_str(), std::ios::binary);
     if (!image_file.good()) {
@@ -442,20 +756,13 @@ Mqtt::receiveMsgRequestImage(const nlohmann::json &data)
                   << std::endl;
         return;
     }
-    std::vector<unsigned char> image_data((std::istreambuf_iterator<char>(image_file)),
-                                          std::istreambuf_iterator<char>());
-    mosquitto_publish(Mqtt::getInstance().mqtt,
-                      NULL,
-                      std::string{Mqtt::getSimIdPrefix() + "out/image"}.c_str(),
-                      image_data.size(),
-                      image_data.data(),
-                      1,
-                      true);
+    std::string image_data((std::istreambuf_iterator<char>(image_file)), std::istreambuf_iterator<char>());
+    Mqtt::getInstance().publishRaw(Mqtt::getSimIdPrefix() + "out/image", std::move(image_data), 1, true);
 
 }
 
 void
-Mqtt::receiveMsgRequestImageBlurred(const nlohmann::json &data)
+Mqtt::receiveMsgRequestImageBlurred(const Command &command)
 {
     std::ifstream image_file("data/lunar_blurred.png", std::ios::binary);
     if (!image_file.good()) {
@@ -463,39 +770,30 @@ Mqtt::receiveMsgRequestImageBlurred(const nlohmann::json &data)
                   << std::endl;
         return;
     }
-    std::vector<unsigned char> image_data((std::istreambuf_iterator<char>(image_file)),
-                                          std::istreambuf_iterator<char>());
-    mosquitto_publish(Mqtt::getInstance().mqtt,
-                      NULL,
-                      std::string{Mqtt::getSimIdPrefix() + "out/image_blurred"}.c_str(),
-                      image_data.size(),
-                      image_data.data(),
-                      1,
-                      true);
+    std::string image_data((std::istreambuf_iterator<char>(image_file)), std::istreambuf_iterator<char>());
+    Mqtt::getInstance().publishRaw(Mqtt::getSimIdPrefix() + "out/image_blurred", std::move(image_data), 1, true);
 }
 
 void
-Mqtt::receiveMsgRobotArm(const nlohmann::json &data)
+Mqtt::receiveMsgRobotArm(const Command &command)
 {
-    try {
-        float speed1 = data["speed1"];
-        float speed2 = data["speed2"];
-        float speed3 = data["speed3"];
-        Mqtt::getInstance().simulation->GetRobot()->GetArm()->SetSpeeds(speed1, speed2, speed3);
-    } catch (std::exception &e) {
-        std::cerr << "Failed to set robot arm velocities: " << e.what() << std::endl;
+    if (!command.has(Command::Speed1 | Command::Speed2 | Command::Speed3)) {
+        std::cerr << "Failed to set robot arm velocities: speed1, speed2 and speed3 have to be numbers" << std::endl;
+        return;
     }
+
+    Mqtt::getInstance().simulation->GetRobot()->GetArm()->SetSpeeds(command.speed1, command.speed2, command.speed3);
 }
 
 void
-Mqtt::receiveMsgRobotArm_Open(const nlohmann::json &data)
+Mqtt::receiveMsgRobotArm_Open(const Command &command)
 {
     Mqtt::getInstance().simulation->GetRobot()->GetArm()->OpenGripper();
     std::cout << "Opening gripper..." << std::endl;
 }
 
 void
-Mqtt::receiveMsgRobotArm_Close(const nlohmann::json &data)
+Mqtt::receiveMsgRobotArm_Close(const Command &command)
 {
     Mqtt::getInstance().simulation->GetRobot()->GetArm()->CloseGripper();
     std::cout << "Closing gripper..." << std::endl;
@@ -515,7 +813,35 @@ Mqtt::getCompressionReceiveInt()
 void
 Mqtt::overrideTopicSettings(const std::string &topic, const TopicSetting &setting)
 {
-    topicSettings.insert(std::make_pair(topic, setting));
+    topicSettings[topic] = setting;
+    getTopicQueue(topic).setting = setting;
+}
+
+const TopicSetting &
+Mqtt::getTopicSetting(std::string_view topic)
+{
+    return getTopicQueue(topic).setting;
+}
+
+void
+Mqtt::setMessageObserver(MessageObserver observer)
+{
+    messageObserver = std::move(observer);
+}
+
+unsigned int
+Mqtt::getDiscardedCount(std::string_view topic)
+{
+    return getTopicQueue(topic).discarded;
+}
+
+void
+Mqtt::resetTopicSettings()
+{
+    topicSettings.clear();
+    for (auto &queue : topicQueues) {
+        queue.setting = TopicSetting{};
+    }
 }
 void
 Mqtt::INTERNAL_SetConnected()
@@ -530,25 +856,25 @@ Mqtt::getSimIdPrefix()
 }
 
 void
-Mqtt::receiveMsgRobotArm_Lock(const nlohmann::json &data)
+Mqtt::receiveMsgRobotArm_Lock(const Command &command)
 {
     Mqtt::getInstance().simulation->GetRobot()->GetArm()->SetLockFolded(true);
 }
 
 void
-Mqtt::receiveMsgRobotArm_UnLock(const nlohmann::json &data)
+Mqtt::receiveMsgRobotArm_UnLock(const Command &command)
 {
     Mqtt::getInstance().simulation->GetRobot()->GetArm()->SetLockFolded(false);
 }
 
 void
-Mqtt::receiveMsgRobotLockBase(const nlohmann::json &data)
+Mqtt::receiveMsgRobotLockBase(const Command &command)
 {
     Mqtt::getInstance().simulation->GetRobot()->SetBaseLock(true);
 }
 
 void
-Mqtt::receiveMsgRobotUnLockBase(const nlohmann::json &data)
+Mqtt::receiveMsgRobotUnLockBase(const Command &command)
 {
     Mqtt::getInstance().simulation->GetRobot()->SetBaseLock(false);
 }
@@ -31,18 +31,47 @@
 #include <string>
 #include <chrono>
 #include <unordered_map>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <string_view>
+#include <vector>
 
 #include <mosquitto.h>
 #include <json.hpp>
 
+#include "command_parser.h"
+#include "compression.h"
+#include "message_writer.h"
+#include "spsc_queue.h"
+
 class Simulation;
 class Settings;
 
 
+// Topics of a higher priority are published first, and lower ones are held back while the I/O thread falls behind
+enum class TopicPriority {
+    Low,
+    Normal,
+    High
+};
+
 struct TopicSetting{
     bool retained = false;
     bool waitForMQTTConnection = false;
     int maxMessages = -1;
+    // Keeps only the newest message of each type and object id until the topic is published
+    bool latestValue = false;
+    // Publishes per second at most, 0 to publish every frame
+    float maxRate = 0.f;
+    // Seconds to hold the first message for others to be published with it
+    float coalesceWindow = 0.f;
+    TopicPriority priority = TopicPriority::Normal;
+    // Publishes the compact binary form of messages that have one, lidar scans so far
+    bool compact = false;
+    // With compact messages, every how many one is complete, the ones between are deltas. 0 or 1 sends no deltas.
+    int keyframeInterval = 0;
 };
 class Mqtt
 {
@@ -53,15 +82,46 @@ public:
 
 
 
+    // Connecting and disconnecting happen on the I/O thread, isConnected turns true once the broker accepted us
     void connectMqtt(const std::string &address, int port);
 
     void disconnectMqtt();
 
     void send(const std::string &topic, const std::string &message_type, const nlohmann::json &payload);
 
+    // Starts a message on the topic and returns the writer for its payload, which takes exactly one value, or nullptr
+    // if the message would be dropped. Finish it with endMessage before starting another. The type has to stay alive
+    // until then. On latest value topics a message replaces the queued one with the same type and object id.
+    MessageWriter *beginMessage(std::string_view topic, std::string_view message_type, unsigned int objectId = 0);
+
+    void endMessage();
+
+    // Called by endMessage with every finished message, {"data": payload, "type": type} as it was queued. Lets
+    // message_check compare the bytes with what nlohmann::json writes.
+    using MessageObserver =
+        std::function<void(std::string_view topic, std::string_view message, MessageWriter::Format format)>;
+
+    void setMessageObserver(MessageObserver observer);
+
     void overrideTopicSettings(const std::string& topic, const TopicSetting& setting);
 
-    void processMqtt(int32_t step);
+    const TopicSetting &getTopicSetting(std::string_view topic);
+
+    // Counts the times messages written to the topic were thrown away before being handed to the I/O thread, because
+    // the message format was switched or the outbound queue was full. Latest value replacements are not counted.
+    unsigned int getDiscardedCount(std::string_view topic);
+
+    // Back to the default settings for every topic, before a new simulation applies its own
+    void resetTopicSettings();
+
+    // Hands the messages queued this frame to the I/O thread, which encodes, compresses and publishes them
+    void processMqtt();
+
+    // Runs the handlers of the control messages and images received since the last call, on the calling thread
+    void receiveQueuedMessages();
+
+    // Publishes the data as it is, from the I/O thread
+    void publishRaw(const std::string &topic, std::string data, int qos, bool retained);
 
     void setSimulationPtr(Simulation* sim){this->simulation = sim;}
 
@@ -84,33 +144,40 @@ public:
 
     float getEmissionSpeed();
 
+    // Level the compression adapted to, from 1 to 9
+    int getCompressionLevel();
+
+    // Fraction of wall time the I/O thread may spend compressing
+    void setCompressionCpuBudget(float budget);
+
     unsigned int getSentBytes();
 
     unsigned int getMessagesSent();
 
-    static void receiveMsgMotors(const nlohmann::json & data);
-    static void receiveMsgPickup(const nlohmann::json & data);
-    static void receiveMsgDrop(const nlohmann::json & data);
-    static void receiveMsgLaserAngle(const nlohmann::json & data);
-    static void receiveMsgLaserShoot(const nlohmann::json & data);
-    static void receiveMsgRobotArm(const nlohmann::json & data);
-    static void receiveMsgRobotArm_Open(const nlohmann::json & data);
-    static void receiveMsgRobotArm_Close(const nlohmann::json & data);
-    static void receiveMsgRobotArm_Lock(const nlohmann::json & data);
-    static void receiveMsgRobotArm_UnLock(const nlohmann::json & data);
-    static void receiveMsgRobotLockBase(const nlohmann::json & data);
-    static void receiveMsgRobotUnLockBase(const nlohmann::json & data);
+    static void receiveMsgMotors(const Command &command);
+    static void receiveMsgPickup(const Command &command);
+    static void receiveMsgDrop(const Command &command);
+    static void receiveMsgLaserAngle(const Command &command);
+    static void receiveMsgLaserShoot(const Command &command);
+    static void receiveMsgRobotArm(const Command &command);
+    static void receiveMsgRobotArm_Open(const Command &command);
+    static void receiveMsgRobotArm_Close(const Command &command);
+    static void receiveMsgRobotArm_Lock(const Command &command);
+    static void receiveMsgRobotArm_UnLock(const Command &command);
+    static void receiveMsgRobotLockBase(const Command &command);
+    static void receiveMsgRobotUnLockBase(const Command &command);
 
     static inline std::string requestImagePath{};
-    static void receiveMsgRequestImage(const nlohmann::json & data);
-    static void receiveMsgRequestImageBlurred(const nlohmann::json & data);
+    static void receiveMsgRequestImage(const Command &command);
+    static void receiveMsgRequestImageBlurred(const Command &command);
 
-    unsigned int receivedMessages{0};
-    unsigned int receivedBytesTotal{0};
-    unsigned int receivedBytesSecond{0};
-    unsigned int receivedBytesLastSecond{0};
+    // Counted on the I/O thread
+    std::atomic<unsigned int> receivedMessages{0};
+    std::atomic<unsigned int> receivedBytesTotal{0};
+    std::atomic<unsigned int> receivedBytesSecond{0};
+    std::atomic<unsigned int> receivedBytesLastSecond{0};
 
-    Simulation* simulation;
+    Simulation* simulation{};
 
     bool printSendingMsgs{true};
     bool printReceivingMsgs{true};
@@ -122,14 +189,111 @@ public:
     // Returns sim/x/
     static std::string getSimIdPrefix();
 
+    // Decodes a received message and queues it for the simulation thread, called by on_message on the I/O thread
+    void receiveMqtt(const mosquitto_message *message);
+
+    // Settings for decoding received messages, copied from the simulation thread every frame
+    std::atomic<int> receiveCompression{0};
+    std::atomic<bool> receiveMessagePack{false};
+    std::atomic<bool> printReceiving{true};
+
 private:
-    // Publishes the payload for the given topic
-    void sendMqtt(const std::string &topic, const std::string &data, bool retained = false);
+    // A received message, decoded on the I/O thread
+    struct InboundMessage
+    {
+        bool isImage{false};
+        std::vector<unsigned char> image;
+        Command command;
+    };
+
+    // Returns false if the simulation has fallen too far behind
+    bool queueInbound(InboundMessage &&message);
+
+    // A message to publish, compressed on the I/O thread unless it is raw. Batches come back through spentMessages so
+    // their buffers are reused.
+    struct OutboundMessage
+    {
+        std::string topic;
+        std::string data;
+        bool isRaw{false};
+        bool retained{false};
+        int qos{0};
+        int compression{0};
+        bool messagePack{false};
+        bool print{false};
+    };
+
+    // A message in TopicQueue::messages, empty once a newer one replaced it
+    struct QueuedMessage
+    {
+        size_t offset;
+        size_t size;
+        uint64_t key; // index of the message type in TopicQueue::types and the object id, for latest value topics
+    };
+
+    // The messages written to a topic since it was last published, already encoded
+    struct TopicQueue
+    {
+        std::string topic;
+        std::string publishTopic;
+        TopicSetting setting;
+        MessageWriter::Format format{MessageWriter::Format::Json};
+        std::string messages;
+        std::vector<QueuedMessage> queued;
+
+        // Message types seen on a latest value topic, and the queued message for each type and object id
+        std::vector<std::string> types;
+        std::unordered_map<uint64_t, size_t> latest;
+
+        size_t count{0};
+        size_t replacedBytes{0};
+        unsigned int discarded{0};
+        double firstQueuedTime{0.0};
+        double lastPublishTime{0.0};
+        bool published{false};
+    };
+
+    TopicQueue &getTopicQueue(std::string_view topic);
+
+    // Identifies the message type and object id within the topic, the same key means the newer message replaces
+    static uint64_t getLatestValueKey(TopicQueue &queue, std::string_view messageType, unsigned int objectId);
+
+    // Whether the rate and coalescing window of the topic let it be published now
+    bool isTopicDue(const TopicQueue &queue, double now) const;
+
+    void publishTopicQueue(TopicQueue &queue, std::chrono::system_clock::time_point timePoint, double now);
+
+    // Drops the bytes of replaced messages
+    void compactTopicQueue(TopicQueue &queue);
+
+    double getQueueTime() const;
+
+    // Publishes the payload for the given topic, on the I/O thread
+    void sendMqtt(const std::string &topic, const std::string &data, int qos, bool retained, bool print);
+
+    // Compresses and publishes a message, on the I/O thread
+    void publishOutbound(OutboundMessage &message);
 
     void sendQueuedMessages();
 
-    // Topic, Message
-    std::unordered_map<std::string, std::vector<nlohmann::json>> queuedMessages;
+    // Returns false if the outbound queue is full and the message was dropped
+    bool queueOutbound(OutboundMessage &&message);
+
+    // Owns the mosquitto client, nothing else touches it once the thread runs
+    void ioLoop();
+
+    // Connects or disconnects as requested by connectMqtt and disconnectMqtt, on the I/O thread
+    void handleConnectionRequests(bool &socketOpen);
+
+    // Few enough topics to search linearly, without building a std::string key per message
+    std::vector<TopicQueue> topicQueues;
+
+    MessageWriter writer;
+    MessageObserver messageObserver;
+
+    TopicQueue *openQueue{};
+    std::string_view openType;
+    uint64_t openKey{};
 
     // Topic, TopicSetting
     std::unordered_map<std::string, TopicSetting> topicSettings;
@@ -140,14 +304,46 @@ private:
 
     void setupMqtt();
 
-    bool is_connected = false;
+    std::atomic<bool> is_connected{false};
 
-    unsigned int sentMessages{0};
-    unsigned int sentBytesTotal{0};
-    unsigned int sentBytesSecond{0};
-    unsigned int sentBytesLastSecond{0};
+    // Counted on the I/O thread
+    std::atomic<unsigned int> sentMessages{0};
+    std::atomic<unsigned int> sentBytesTotal{0};
+    std::atomic<unsigned int> sentBytesSecond{0};
+    std::atomic<unsigned int> sentBytesLastSecond{0};
+    std::atomic<unsigned int> droppedMessages{0};
+
+    // Wall clock time of the last bytes per second sample
+    std::chrono::steady_clock::time_point statsTimePoint{std::chrono::steady_clock::now()};
 
     mosquitto *mqtt;
+
+    // Simulation thread to I/O thread and back
+    static constexpr size_t outboundCapacity = 4096;
+    SpscQueue<OutboundMessage> outbound{outboundCapacity};
+    SpscQueue<OutboundMessage> spentMessages{outboundCapacity};
+    SpscQueue<InboundMessage> inbound{1024};
+
+    // Used by the I/O thread only. The topics are built once per connection instead of per received message.
+    std::string controlTopic;
+    std::string imageTopic;
+    CommandParser commandParser;
+    Decompressor decompressor;
+    std::string inflated;
+    Compressor compressor;
+    std::string compressed;
+    std::atomic<int> compressionLevel{0};
+    std::atomic<float> compressionCpuBudget{0.05f};
+
+    // Connection requests for the I/O thread, rare enough for a lock
+    std::mutex connectionMutex;
+    bool connectRequested{false};
+    bool disconnectRequested{false};
+    std::string connectAddress;
+    int connectPort{};
+
+    std::atomic<bool> stopIo{false};
+    std::thread ioThread;
 };
 
 #endif // MARSIM_MQTT_H
@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include "object.h"
+#include "arena.h"
 #include "simulation.h"
 
 b2Vec2
@@ -50,9 +51,9 @@ Object::completeStopVelocity()
 }
 
 void
-Object::addForce(b2Vec2 force)
+Object::addForce(b2Vec2 force, bool wake)
 {
-    body->ApplyForceToCenter(force, true);
+    body->ApplyForceToCenter(force, wake);
 }
 void
 Object::setPosition(b2Vec2 pos, float angle)
@@ -67,6 +68,30 @@ Object::Object(Simulation *simulation)
     object_id = id_incrementor++;
 }
 
+Object::~Object()
+{
+    simulation->Unschedule(publishHandle);
+}
+
+void *
+Object::operator new(size_t size)
+{
+    return Arena::allocateActive(size);
+}
+
+void
+Object::operator delete(void *ptr)
+{
+    Arena::release(ptr);
+}
+
+void
+Object::setPublishInterval(double interval)
+{
+    simulation->Unschedule(publishHandle);
+    publishHandle = interval > 0.0 ? simulation->Schedule(interval, [this] { publish(); }) : SlotHandle{};
+}
+
 std::vector<Object *>
 Object::getAttachedObjects()
 {
@@ -24,18 +24,53 @@
 #define MARSIM_OBJECT_H
 
 #include "box2d/box2d.h"
+#include "slot_map.h"
 
 #include <string>
 #include <vector>
 
 class Simulation;
 
+// Collision filter categories. Sensors and ray casts choose what they detect with masks of these bits.
+namespace CollisionCategory {
+constexpr uint16 Default = 0x0001; // Box2D's default category, used by the weather sensors
+constexpr uint16 Robot = 0x0002;
+constexpr uint16 RobotPart = 0x0004; // wheels and arm
+constexpr uint16 Stone = 0x0008;
+constexpr uint16 Alien = 0x0010;
+constexpr uint16 Sensor = 0x0020; // proximity sensors and everything derived from them
+constexpr uint16 AllButSensors = 0xFFFF & ~Sensor;
+} // namespace CollisionCategory
+
+// Concrete type of an object, set by its constructor so the simulation can sort objects without RTTI
+enum class ObjectType {
+    Unknown,
+    Robot,
+    Wheel,
+    RobotArm,
+    Stone,
+    Alien,
+    ProximitySensor,
+    PickupSensor,
+    FrictionZone,
+    Tornado,
+    Volcano,
+    WeatherSensor,
+    WindSensor,
+    SeismicSensor,
+    TemperatureSensor
+};
+
 class Object
 {
 
 public:
     Object(Simulation *simulation);
-    virtual ~Object() = default;
+    virtual ~Object();
+
+    // Objects are allocated from the arena of the active simulation
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr);
 
     virtual b2Vec2 getLocalVelocity();
 
@@ -45,7 +80,8 @@ public:
 
     void completeStopVelocity();
 
-    void addForce(b2Vec2 force);
+    // Sleeping bodies only pick up the force if wake is set
+    void addForce(b2Vec2 force, bool wake = true);
 
     void setPosition(b2Vec2 pos, float angle);
 
@@ -59,13 +95,28 @@ public:
 
     virtual void update() = 0;
 
+    // Called every publish interval, staggered against other objects so they do not all publish on the same step
+    virtual void publish(){};
+
+    // Debug drawing, called every step while shapes are drawn for objects that are drawable
+    virtual void draw(){};
+
+    // Seconds of simulated time between calls to publish, replacing the previous interval. 0 stops publishing.
+    void setPublishInterval(double interval);
+
     b2Body *body{};
 
     bool updateable = true;
+    bool drawable = false;
     bool terrain_movable = true;
 
     std::string name{"Unknown Object"};
 
+    ObjectType type{ObjectType::Unknown};
+
+    // Set by the simulation while the object is simulated
+    SlotHandle handle, updateHandle, drawHandle, worldStateHandle;
+
     unsigned int GetObjectId();
 
     void SetObjectId(unsigned int id);
@@ -75,6 +126,8 @@ protected:
     static inline unsigned int id_incrementor{0};
     unsigned int object_id;
 
+    SlotHandle publishHandle;
+
     float angularDamping{25.f}, linearDamping{12.5f};
 
     b2World *world;
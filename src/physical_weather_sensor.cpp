@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include "physical_weather_sensor.h"
+#include "simulation.h"
 
 
 PhysicalWeatherSensor::PhysicalWeatherSensor(Simulation* simulation, b2Vec2 pos) : Object(simulation) {
@@ -47,7 +48,16 @@ PhysicalWeatherSensor::PhysicalWeatherSensor(Simulation* simulation, b2Vec2 pos)
     fixdef.shape = &shape;
     body->CreateFixture(&fixdef);
 
+    // Weather sensors only draw and publish, they are never updated. With sensor frames, the simulation publishes
+    // all of them at once instead.
+    updateable = false;
+    drawable = true;
+    if (simulation->setup.sensorFrameInterval <= 0.f) {
+        setPublishInterval(publishInterval);
+    }
+
     name = "Weather Sensor";
+    type = ObjectType::WeatherSensor;
 }
 
 void
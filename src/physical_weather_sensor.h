@@ -33,8 +33,12 @@ public:
 
     void update() override;
 
+    // Position last sent in a sensor frame, which sends it again only once it changed
+    b2Vec2 framePosition{};
+    bool framePositionSent{false};
+
 protected:
-    uint32_t updateFrequency{30};
+    static constexpr double publishInterval{0.5}; // seconds
 };
 
 #endif // MARSIM_PHYSICAL_WEATHER_SENSOR_H
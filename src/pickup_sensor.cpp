@@ -23,11 +23,12 @@
 #include "pickup_sensor.h"
 
 #include "robot.h"
+#include "simulation.h"
 
 PickupSensor::PickupSensor(Simulation* simulation, Robot *robot, b2Vec2 pos, float radius) : ProximitySensor(simulation)
 {
     terrain_movable = false;
-    updateFrequency = 10;
+    setPublishInterval(1.0 / 6.0);
 
     this->radius = radius;
 
@@ -38,20 +39,12 @@ PickupSensor::PickupSensor(Simulation* simulation, Robot *robot, b2Vec2 pos, flo
     def.angle = robot->body->GetAngle();
     body = world->CreateBody(&def);
 
-    // Triangle
-    b2Vec2 vertices[3];
-    vertices[0].Set(0, -1);
-    vertices[1].Set(-1.5,1);
-    vertices[2].Set(1.5,1);
-
-    b2CircleShape shape;
-    shape.m_radius = radius;
-
-    b2FixtureDef fixdef;
-    fixdef.isSensor = true;
-    fixdef.shape = &shape;
-    fixdef.userData.pointer = reinterpret_cast<uintptr_t>(this);
-    body->CreateFixture(&fixdef);
+    // The sensor is moved with the gripper every step, so it queries the world instead of holding a fixture
+    queryBased = true;
+    simulation->AddQuerySensor(this);
+    updateable = false;
+    drawable = true;
 
     name = "Pickup Sensor";
+    type = ObjectType::PickupSensor;
 }
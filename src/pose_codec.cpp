@@ -0,0 +1,87 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pose_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+constexpr uint8_t poseVersion = 1;
+constexpr size_t poseSize = 11;
+constexpr double millimetresPerMetre = 1000.0;
+constexpr double pi = 3.14159265358979323846;
+constexpr double headingSteps = 32768.0 / pi;
+
+int32_t
+toMillimetres(float metres)
+{
+    return static_cast<int32_t>(std::clamp(std::round(metres * millimetresPerMetre), -2147483648.0, 2147483647.0));
+}
+
+void
+appendBytes(std::string &out, uint32_t value, int count)
+{
+    for (int i = 0; i < count; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint32_t
+readBytes(const char *data, int count)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < count; i++) {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+} // namespace
+
+void
+encodePose(float x, float y, float r, std::string &out)
+{
+    // A heading of pi rounds to 32768, which wraps around to -pi like it should
+    const auto heading = static_cast<uint16_t>(std::lround(std::remainder(r, 2.0 * pi) * headingSteps));
+
+    out.clear();
+    out.push_back(static_cast<char>(poseVersion));
+    appendBytes(out, static_cast<uint32_t>(toMillimetres(x)), 4);
+    appendBytes(out, static_cast<uint32_t>(toMillimetres(y)), 4);
+    appendBytes(out, heading, 2);
+}
+
+bool
+decodePose(std::string_view data, float &x, float &y, float &r)
+{
+    if (data.size() != poseSize || static_cast<uint8_t>(data[0]) != poseVersion) {
+        return false;
+    }
+
+    x = static_cast<float>(static_cast<int32_t>(readBytes(data.data() + 1, 4)) / millimetresPerMetre);
+    y = static_cast<float>(static_cast<int32_t>(readBytes(data.data() + 5, 4)) / millimetresPerMetre);
+    r = static_cast<float>(static_cast<int16_t>(readBytes(data.data() + 9, 2)) / headingSteps);
+    return true;
+}
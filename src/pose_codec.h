@@ -0,0 +1,42 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_POSE_CODEC_H
+#define MARSIM_POSE_CODEC_H
+
+#include <string>
+#include <string_view>
+
+// Fixed-point robot pose, published as {"pose": <bytes>} instead of {"pos": {"r", "x", "y"}}. Little endian:
+//
+//   u8  version, 1
+//   i32 x, millimetres
+//   i32 y, millimetres
+//   i16 heading, in 1/32768 of half a turn, wrapped to [-pi, pi)
+
+// Replaces the contents of out, which keeps its capacity
+void encodePose(float x, float y, float r, std::string &out);
+
+// Returns false if the data is malformed
+bool decodePose(std::string_view data, float &x, float &y, float &r);
+
+#endif // MARSIM_POSE_CODEC_H
@@ -24,15 +24,62 @@
 #include "simulation.h"
 #include <iostream>
 
+#include "framework/draw.h"
 #include "json.hpp"
 #include "mqtt.h"
 
-ProximitySensor::ProximitySensor(Simulation *simulation, b2Vec2 pos, float radius, bool isDynamic, bool updatedBySim)
+namespace {
+
+// Collects the objects whose fixtures overlap a circle, with the same filtering Box2D applies to sensor contacts
+struct CircleQuery : public b2QueryCallback
+{
+    bool
+    ReportFixture(b2Fixture *fixture) override
+    {
+        b2Body *other = fixture->GetBody();
+        if (other == sensorBody || other->GetType() != b2_dynamicBody) {
+            return true;
+        }
+
+        const b2Filter &filter = fixture->GetFilterData();
+        if ((filter.categoryBits & maskBits) == 0 || (filter.maskBits & CollisionCategory::Sensor) == 0) {
+            return true;
+        }
+
+        auto object = reinterpret_cast<Object *>(fixture->GetUserData().pointer);
+        if (std::find(objects->begin(), objects->end(), object) != objects->end()) {
+            return true;
+        }
+
+        const b2Shape *shape = fixture->GetShape();
+        for (int32 child = 0; child < shape->GetChildCount(); child++) {
+            if (b2TestOverlap(&circle, 0, shape, child, transform, other->GetTransform())) {
+                objects->push_back(object);
+                break;
+            }
+        }
+        return true;
+    }
+
+    b2CircleShape circle;
+    b2Transform transform;
+    b2Body *sensorBody{};
+    uint16 maskBits{};
+    std::vector<Object *> *objects{};
+};
+
+} // namespace
+
+ProximitySensor::ProximitySensor(Simulation *simulation, b2Vec2 pos, float radius, bool isDynamic, bool updatedBySim,
+                                 bool queryBased)
     : Object(simulation)
 {
     terrain_movable = false;
 
     updateable = updatedBySim;
+    if (updatedBySim) {
+        setPublishInterval(publishInterval);
+    }
 
     this->radius = radius;
 
@@ -47,52 +94,91 @@ ProximitySensor::ProximitySensor(Simulation *simulation, b2Vec2 pos, float radiu
     def.bullet = false;
     this->body = world->CreateBody(&def);
 
-    b2CircleShape shape;
-    shape.m_radius = radius;
+    this->queryBased = queryBased;
+    if (queryBased) {
+        // The objects inside are found when read, so there is nothing to update
+        simulation->AddQuerySensor(this);
+        updateable = false;
+        drawable = true;
+    } else {
+        b2CircleShape shape;
+        shape.m_radius = radius;
 
-    b2FixtureDef fd;
-    fd.shape = &shape;
-    fd.isSensor = true;
-    fd.userData.pointer = reinterpret_cast<uintptr_t>(this);
-    body->CreateFixture(&fd);
+        b2FixtureDef fd;
+        fd.shape = &shape;
+        fd.isSensor = true;
+        fd.filter.categoryBits = CollisionCategory::Sensor;
+        fd.filter.maskBits = detectedCategories;
+        fd.userData.pointer = reinterpret_cast<uintptr_t>(this);
+        body->CreateFixture(&fd);
+    }
 
     name = "Proximity Sensor";
+    type = ObjectType::ProximitySensor;
+}
+
+ProximitySensor::~ProximitySensor()
+{
+    if (queryBased) {
+        simulation->RemoveQuerySensor(this);
+    }
 }
 
 void
 ProximitySensor::update()
 {
+}
+
+void
+ProximitySensor::draw()
+{
+    // Only query based sensors are drawable, there is no fixture for the debug draw to show
+    g_debugDraw.DrawCircle(getPosition(), radius, b2Color{0.5f, 0.5f, 0.9f});
+}
 
-    if (!shouldTransmitMqtt) {
+void
+ProximitySensor::publish()
+{
+    auto writer = Mqtt::getInstance().beginMessage("out/general", name, object_id);
+    if (!writer) {
         return;
     }
 
-    if (simulation->GetStepCount() % updateFrequency == 0) {
+    QueryObjectsInside();
 
-        nlohmann::json j;
+    auto pos = getPosition();
+    writer->beginObject(4);
+    writer->key("id");
+    writer->value(object_id);
+    writer->key("pos");
+    writer->pose(pos.x, pos.y, body->GetAngle());
+    writer->key("radius");
+    writer->value(radius);
 
-        auto pos = getPosition();
-        j["pos"] = {{"x", pos.x}, {"y", pos.y}, {"r", body->GetAngle()}};
-        j["radius"] = radius;
-
-        j["id"] = object_id;
-
-        nlohmann::json objects;
+    // An empty list used to be a null json
+    writer->key("sensed_objs");
+    if (objects_inside.empty()) {
+        writer->null();
+    } else {
+        writer->beginArray(objects_inside.size());
         for (auto &&object : objects_inside) {
-            nlohmann::json objectJson;
-
-            auto pos = object->getPosition();
-            objectJson["pos"] = {{"x", pos.x}, {"y", pos.y}, {"r", object->body->GetAngle()}};
-            objectJson["name"] = object->name;
-            objectJson["id"] = object->GetObjectId();
-            objectJson["mass"] = object->GetMass();
-
-            objects.push_back(objectJson);
+            auto objectPos = object->getPosition();
+            writer->beginObject(4);
+            writer->key("id");
+            writer->value(object->GetObjectId());
+            writer->key("mass");
+            writer->value(object->GetMass());
+            writer->key("name");
+            writer->value(object->name);
+            writer->key("pos");
+            writer->pose(objectPos.x, objectPos.y, object->body->GetAngle());
+            writer->endObject();
         }
-
-        j["sensed_objs"] = objects;
-        Mqtt::getInstance().send("out/general", name, j);
+        writer->endArray();
     }
+    writer->endObject();
+
+    Mqtt::getInstance().endMessage();
 }
 
 void
@@ -107,15 +193,31 @@ ProximitySensor::ObjectLeave(Object *other)
 {
     auto it = std::find(objects_inside.begin(), objects_inside.end(), other);
     if (it != objects_inside.end()) {
-        objects_inside.erase(it);
+        // The order does not matter, so avoid shifting the rest
+        *it = objects_inside.back();
+        objects_inside.pop_back();
     }
     OnObjectLeave(other);
 }
 
+void
+ProximitySensor::ObjectDestroyed(Object *other)
+{
+    if (std::find(objects_inside.begin(), objects_inside.end(), other) != objects_inside.end()) {
+        ObjectLeave(other);
+    }
+}
+
 void
 ProximitySensor::setRadius(float r)
 {
     this->radius = r;
+
+    if (queryBased) {
+        queriedStep = -1;
+        return;
+    }
+
     body->DestroyFixture(body->GetFixtureList());
 
     b2CircleShape shape;
@@ -124,25 +226,80 @@ ProximitySensor::setRadius(float r)
     b2FixtureDef fd;
     fd.shape = &shape;
     fd.isSensor = true;
+    fd.filter.categoryBits = CollisionCategory::Sensor;
+    fd.filter.maskBits = detectedCategories;
     fd.userData.pointer = reinterpret_cast<uintptr_t>(this);
     body->CreateFixture(&fd);
 }
 
+void
+ProximitySensor::setDetectedCategories(uint16 categories)
+{
+    detectedCategories = categories;
+    queriedStep = -1;
+
+    for (b2Fixture *fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext()) {
+        b2Filter filter = fixture->GetFilterData();
+        filter.maskBits = categories;
+        fixture->SetFilterData(filter);
+    }
+}
+
 std::vector<Object *>
 ProximitySensor::getObjectsInside()
 {
+    QueryObjectsInside();
     return objects_inside;
 }
 
+void
+ProximitySensor::QueryObjectsInside()
+{
+    if (!queryBased) {
+        return;
+    }
+
+    auto position = getPosition();
+    if (queriedStep == simulation->GetStepCount() && queriedPosition == position) {
+        return;
+    }
+    queriedStep = simulation->GetStepCount();
+    queriedPosition = position;
+
+    queriedObjects.clear();
+
+    CircleQuery query;
+    query.circle.m_radius = radius;
+    query.transform = body->GetTransform();
+    query.sensorBody = body;
+    query.maskBits = detectedCategories;
+    query.objects = &queriedObjects;
+
+    b2AABB aabb;
+    aabb.lowerBound = position - b2Vec2{radius, radius};
+    aabb.upperBound = position + b2Vec2{radius, radius};
+    world->QueryAABB(&query, aabb);
+
+    for (int i = static_cast<int>(objects_inside.size()) - 1; i >= 0; i--) {
+        auto object = objects_inside[i];
+        if (std::find(queriedObjects.begin(), queriedObjects.end(), object) == queriedObjects.end()) {
+            ObjectLeave(object);
+        }
+    }
+
+    for (auto &&object : queriedObjects) {
+        if (std::find(objects_inside.begin(), objects_inside.end(), object) == objects_inside.end()) {
+            ObjectEnter(object);
+        }
+    }
+}
+
 ProximitySensor::ProximitySensor(Simulation *simulation) : Object(simulation) {}
 void
 ProximitySensor::MoveToMiddleMouseButtonPressPosition()
 {
-    if (glfwGetMouseButton(simulation->window, GLFW_MOUSE_BUTTON_MIDDLE)) {
-        double xd, yd;
-        glfwGetCursorPos(g_mainWindow, &xd, &yd);
-        b2Vec2 ps((float)xd, (float)yd);
-        b2Vec2 pw = g_camera.ConvertScreenToWorld(ps);
+    if (simulation->IsMiddleMouseDown()) {
+        b2Vec2 pw = simulation->GetMouseWorld();
 
         auto diff = pw - getPosition();
         if (diff.Length() < radius) {
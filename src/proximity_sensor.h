@@ -30,19 +30,33 @@ class ProximitySensor : public Object
 {
 public:
     
-    ProximitySensor(Simulation* simulation, b2Vec2 pos, float radius, bool isDynamic = false, bool updatedBySim = true);
+    // A sensor updated by the simulation publishes the objects inside, unless told otherwise with setPublishInterval.
+    // A query based sensor has no fixture. It finds the objects inside with a world query when they are read, so
+    // moving it is free and it costs nothing while nobody reads it.
+    ProximitySensor(Simulation* simulation, b2Vec2 pos, float radius, bool isDynamic = false, bool updatedBySim = true,
+                    bool queryBased = false);
+
+    ~ProximitySensor() override;
 
     void ObjectEnter(Object* other);
 
     void ObjectLeave(Object* other);
 
+    // Called for query based sensors when an object is destroyed, since there is no contact to end
+    void ObjectDestroyed(Object* other);
+
     void setRadius(float r);
 
+    // Only objects with a category in the mask generate contacts with the sensor
+    void setDetectedCategories(uint16 categories);
+
     void update() override;
 
-    std::vector<Object*> getObjectsInside();
+    void publish() override;
 
-    bool shouldTransmitMqtt = true;
+    void draw() override;
+
+    std::vector<Object*> getObjectsInside();
 
 protected:
     explicit ProximitySensor(Simulation* simulation);
@@ -50,11 +64,22 @@ protected:
     virtual void OnObjectEnter(Object * o){};
     virtual void OnObjectLeave(Object * o){};
 
+    // Finds the objects inside with a world query and calls the enter and leave hooks for the differences. Does
+    // nothing for contact based sensors, or if the sensor has not moved since the last query in this step.
+    void QueryObjectsInside();
+
     std::vector<Object*> objects_inside;
 
+    bool queryBased{false};
+    int32 queriedStep{-1};
+    b2Vec2 queriedPosition{};
+    std::vector<Object*> queriedObjects;
+
     float radius{15.f};
 
-    int updateFrequency = 20;
+    uint16 detectedCategories{CollisionCategory::AllButSensors};
+
+    static constexpr double publishInterval = 1.0 / 3.0; // seconds
 
     void MoveToMiddleMouseButtonPressPosition();
 
@@ -21,27 +21,20 @@
 // SOFTWARE.
 
 #include "raycast.h"
-#include "proximity_sensor.h"
-#include "robot_arm.h"
-#include "wheel.h"
 
 Raycast::Raycast() = default;
 
+Raycast::Raycast(uint16 maskBits) : m_maskBits(maskBits) {}
+
 float
 Raycast::ReportFixture(b2Fixture *fixture, const b2Vec2 &point, const b2Vec2 &normal, float fraction)
 {
-    auto ptr = reinterpret_cast<Object *>(fixture->GetUserData().pointer);
-    // Ignore wheels and proximity sensors
-    if (auto wheel = dynamic_cast<Wheel *>(ptr)) {
-        return -1.0f;
-    }
-    if (auto proxSensor = dynamic_cast<ProximitySensor *>(ptr)) {
-        return -1.0f;
-    }
-    if (auto robotArm = dynamic_cast<RobotArm *>(ptr)) {
+    if ((fixture->GetFilterData().categoryBits & m_maskBits) == 0) {
         return -1.0f;
     }
 
+    auto ptr = reinterpret_cast<Object *>(fixture->GetUserData().pointer);
+
     m_hit = ptr;
     m_point = point;
     m_normal = normal;
@@ -23,20 +23,24 @@
 #ifndef MARSIM_RAYCAST_H
 #define MARSIM_RAYCAST_H
 
-#include "box2d/box2d.h"
-
-class Object;
+#include "object.h"
 
 class Raycast : public b2RayCastCallback
 {
 public:
     Raycast();
 
+    // Only fixtures with a category in the mask are hit
+    explicit Raycast(uint16 maskBits);
+
     float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override;
 
     Object* m_hit{nullptr};
     b2Vec2 m_point{};
     b2Vec2 m_normal{};
+
+    // Wheels, the arm and proximity sensors are ignored by default
+    uint16 m_maskBits{CollisionCategory::AllButSensors & ~CollisionCategory::RobotPart};
 };
 
 #endif // MARSIM_RAYCAST_H
@@ -25,6 +25,7 @@
 #include "laser.h"
 #include "mqtt.h"
 #include "pickup_sensor.h"
+#include "pose_codec.h"
 #include "robot_arm.h"
 #include "seismic_sensor.h"
 #include "simulation.h"
@@ -33,6 +34,8 @@
 #include "wind_sensor.h"
 #include "lidar_sensor.h"
 
+#include <algorithm>
+#include <cmath>
 #include <glm/gtx/rotate_vector.hpp>
 #include <iostream>
 #include <json.hpp>
@@ -64,6 +67,7 @@ Robot::Robot(
 
     b2FixtureDef fixdef;
     fixdef.filter.groupIndex = -1;
+    fixdef.filter.categoryBits = CollisionCategory::Robot;
     fixdef.density = 1.0;
     fixdef.friction = 0.5;
     fixdef.restitution = 0.4;
@@ -75,10 +79,12 @@ Robot::Robot(
 
     pickup_sensor = new PickupSensor{simulation, this, {0.f, 5.f}, 0.896f};
 
-    proximity_sensor = new ProximitySensor{simulation, position, 30.f, true};
-    proximity_sensor->shouldTransmitMqtt = false;
+    proximity_sensor = new ProximitySensor{simulation, position, 30.f, true, true, true};
+    proximity_sensor->setPublishInterval(0.0);
 
     lidarSensor = new LidarSensor{simulation, 30, position};
+    lidarSensor->setAngularResolution(simulation->setup.lidarAngularResolution);
+    lidarSensor->setFrequency(simulation->setup.lidarFrequency);
 
     laser = new Laser{world, 45.f};
     laser->setPosition(position);
@@ -87,7 +93,10 @@ Robot::Robot(
 
     robot_arm = new RobotArm{simulation, body};
 
+    setPublishInterval(1.0 / 20.0);
+
     name = "Robot";
+    type = ObjectType::Robot;
 }
 
 void
@@ -101,15 +110,15 @@ Robot::update()
 {
     //uncomment below if you want to print the battery percentage
     //std::cout << battery->getSoC() * 100 << std::endl;
+    const float dt = simulation->GetTimeStep();
+
     battery->reset_current_tick_drain();
     //use of energy just for staying on, for sensors and all
-    battery->BatUpdate(1.5);
-
-    robot_arm->update();
+    battery->BatUpdate(1.5, dt);
 
     if(!isInShadow()){
         //constant charge with 3 amps per update if not in shadow zone
-        battery->BatUpdate(-3);
+        battery->BatUpdate(-3, dt);
     }
 
 
@@ -125,14 +134,14 @@ Robot::update()
         b2Vec2 force = {0.f, this->power * frs * leftAccelerate};
         this->wheels[0]->body->ApplyForce(wheels[0]->body->GetWorldVector(force), pos, true);
 
-        battery->BatUpdate((1.f-(getSpeedKMH()/maxSpeed)) * frs * abs(leftAccelerate) * 12);
+        battery->BatUpdate((1.f-(getSpeedKMH()/maxSpeed)) * frs * abs(leftAccelerate) * 12, dt);
     }
 
     if (rightAccelerate != 0.f && getSpeedKMH() < maxSpeed) {
         auto pos = this->wheels[1]->body->GetWorldCenter();
         b2Vec2 force = {0.f, this->power * frs * rightAccelerate};
         this->wheels[1]->body->ApplyForce(wheels[1]->body->GetWorldVector(force), pos, true);
-        battery->BatUpdate((1.f-(getSpeedKMH()/maxSpeed)) * frs * abs(rightAccelerate) * 12);
+        battery->BatUpdate((1.f-(getSpeedKMH()/maxSpeed)) * frs * abs(rightAccelerate) * 12, dt);
     }
 
     // If going very slowly, stop the car completely.
@@ -145,13 +154,9 @@ Robot::update()
     auto forward = glm::rotate(glm::vec2{cos(angle), sin(angle)}, glm::radians(90.f));
     forward *= 3.f;
     pickup_sensor->setPosition(robot_arm->GetGripperPosition(), 0.f);
-    pickup_sensor->body->SetAwake(true); // Since we manually move the sensor, we need to wake it up all the time.
-    pickup_sensor->update();
 
     // Set position for proximity sensor
     proximity_sensor->setPosition(getPosition(), 0.f);
-    proximity_sensor->body->SetAwake(true); // Since we manually move the sensor, we need to wake it up all the time.
-    proximity_sensor->update();
 
     laser->setPosition(getPosition());
     laser->setAngle(glm::degrees(body->GetAngle()) + laserAngleDegrees);
@@ -162,41 +167,107 @@ Robot::update()
 
     }
     if (shootNextUpdate) {
-        battery->BatUpdate(260);
+        // One-off drain per shot, independent of the step length
+        battery->BatUpdate(260, 1.0 / 60.0);
         shootNextUpdate = false;
     }
 
-    if (updateCounter % 3 == 0) {
-        nlohmann::json j;
+    if (isPoseDue(publishedPose)) {
+        publishPose();
+    }
 
-        auto pos = getPosition();
-        j["pos"] = {{"x", pos.x}, {"y", pos.y}, {"r", body->GetAngle()}};
-        j["battery"] = (battery->getSoC() * 100); // Yet to be tested
-        j["storage"] = storage;
-        j["in_shadow"] = isInShadow();
-        j["base_locked"] = IsBaseLocked();
+    lidarSensor->setPosition(getPosition());
+    lidarSensor->update();
+}
 
-        Mqtt::getInstance().send("out/general", "Robot", j);
+bool
+Robot::isPoseDue(const PublishedPose &published)
+{
+    const auto &setup = simulation->setup;
+    if (published.time < 0.0 || simulation->GetSimulationTime() - published.time >= setup.poseKeyframeInterval) {
+        return true;
     }
+    return (getPosition() - published.position).Length() >= setup.poseMinDistance ||
+           std::abs(body->GetAngle() - published.angle) >= glm::radians(setup.poseMinAngle);
+}
 
-    // 60 Hz robot position sync
-    if(updateCounter % 1 == 0)
-    {
-        nlohmann::json j;
+void
+Robot::setPublished(PublishedPose &published)
+{
+    published.position = getPosition();
+    published.angle = body->GetAngle();
+    published.time = simulation->GetSimulationTime();
+}
 
-        auto pos = getPosition();
-        j["pos"] = {{"x", pos.x}, {"y", pos.y}, {"r", body->GetAngle()}};
+void
+Robot::publishPose()
+{
+    auto writer = Mqtt::getInstance().beginMessage("out/robotpos", "RobotPos");
+    if (!writer) {
+        return;
+    }
 
-        //if(body->GetAngularVelocity() > 0.01f || body->GetLinearVelocity().Length() > 0.01f)
-        //{
-            Mqtt::getInstance().send("out/robotpos", "RobotPos", j);
-        //}
+    setPublished(publishedPose);
+    const auto &pos = publishedPose.position;
+    writer->beginObject(1);
+    if (Mqtt::getInstance().getTopicSetting("out/robotpos").compact) {
+        encodePose(pos.x, pos.y, publishedPose.angle, encodedPose);
+        writer->key("pose");
+        writer->binary(encodedPose);
+    } else {
+        writer->key("pos");
+        writer->pose(pos.x, pos.y, publishedPose.angle);
     }
+    writer->endObject();
+    Mqtt::getInstance().endMessage();
+}
 
-    lidarSensor->setPosition(getPosition());
-    lidarSensor->update();
+void
+Robot::publish()
+{
+    // Percentage points the battery drains before it is published again
+    constexpr double batteryStep = 0.1;
+
+    const double batteryPercent = battery->getSoC() * 100;
+    const bool baseLocked = IsBaseLocked();
+    const bool inShadow = isInShadow();
+    if (!isPoseDue(publishedGeneral) && std::abs(batteryPercent - publishedBattery) < batteryStep &&
+        baseLocked == publishedBaseLocked && inShadow == publishedInShadow &&
+        storageRevision == publishedStorageRevision) {
+        return;
+    }
 
-    updateCounter++;
+    auto writer = Mqtt::getInstance().beginMessage("out/general", "Robot");
+    if (!writer) {
+        return;
+    }
+
+    setPublished(publishedGeneral);
+    publishedBattery = batteryPercent;
+    publishedBaseLocked = baseLocked;
+    publishedInShadow = inShadow;
+    publishedStorageRevision = storageRevision;
+
+    // Keys in sorted order, the same as nlohmann::json writes them
+    auto pos = getPosition();
+    writer->beginObject(5);
+    writer->key("base_locked");
+    writer->value(baseLocked);
+    writer->key("battery");
+    writer->value(batteryPercent); // Yet to be tested
+    writer->key("in_shadow");
+    writer->value(inShadow);
+    writer->key("pos");
+    writer->pose(pos.x, pos.y, body->GetAngle());
+    writer->key("storage");
+    writer->beginArray(storage.size());
+    for (auto &&item : storage) {
+        writer->value(item);
+    }
+    writer->endArray();
+    writer->endObject();
+
+    Mqtt::getInstance().endMessage();
 }
 
 Robot::~Robot()
@@ -214,6 +285,24 @@ Robot::~Robot()
 
 void
 Robot::pickup()
+{
+    pickupItem(nullptr);
+}
+
+void
+Robot::pickup(unsigned int id)
+{
+    auto target = simulation->FindObject(id);
+    if (!target) {
+        Mqtt::getInstance().send("out/pickup", "pickup", "FAIL");
+        return;
+    }
+
+    pickupItem(target);
+}
+
+void
+Robot::pickupItem(Object *target)
 {
 
     if(robot_arm->IsGripperOpen())
@@ -231,6 +320,14 @@ Robot::pickup()
         }
     }
 
+    if (target) {
+        if (std::find(items.begin(), items.end(), target) == items.end()) {
+            items.clear();
+        } else {
+            items = {target};
+        }
+    }
+
     if (items.empty()) {
         Mqtt::getInstance().send("out/pickup", "pickup", "FAIL");
         return;
@@ -245,6 +342,7 @@ Robot::pickup()
     j["id"] = item->GetObjectId();
 
     storage.push_back(j);
+    storageRevision++;
 
     simulation->DestroyObjectNextFrame(item);
 
@@ -302,6 +400,7 @@ Robot::drop(unsigned int index)
     }
 
     storage.erase(storage.begin() + index);
+    storageRevision++;
 
     recalculateMass();
 
@@ -374,6 +473,12 @@ Robot::GetArm()
     return robot_arm;
 }
 
+LidarSensor *
+Robot::GetLidar()
+{
+    return lidarSensor;
+}
+
 bool
 Robot::IsBaseLocked()
 {
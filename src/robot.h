@@ -31,6 +31,7 @@
 
 #include <glm/glm.hpp>
 #include <json.hpp>
+#include <string>
 #include <vector>
 
 
@@ -41,6 +42,14 @@ class LidarSensor;
 class Laser;
 class RobotArm;
 
+// A pose as it was last published, to publish again only once it changed enough
+struct PublishedPose
+{
+    b2Vec2 position{};
+    float angle{};
+    double time{-1.0}; // simulated seconds, negative until first published
+};
+
 class Robot : public Object
 {
 public:
@@ -59,8 +68,13 @@ public:
 
     void update() override;
 
+    void publish() override;
+
     void pickup();
 
+    // Picks up the object with the id, if it is within reach
+    void pickup(unsigned int id);
+
     bool drop(unsigned int index);
 
     float getStorageMass();
@@ -89,8 +103,18 @@ public:
 
     RobotArm* GetArm();
 
+    LidarSensor* GetLidar();
+
 private:
-    unsigned int updateCounter{0};
+    // Picks up the target, or the first item within reach if the target is null
+    void pickupItem(Object *target);
+
+    // Whether the pose moved or turned past the thresholds of the setup, or its keyframe is due
+    bool isPoseDue(const PublishedPose &published);
+
+    void setPublished(PublishedPose &published);
+
+    void publishPose();
 
     PickupSensor* pickup_sensor{};
     ProximitySensor* proximity_sensor{};
@@ -106,6 +130,15 @@ private:
 
     std::vector<nlohmann::json> storage;
     float storageMass{0.f};
+    unsigned int storageRevision{0}; // counts every change of the storage
+
+    PublishedPose publishedPose;    // out/robotpos
+    PublishedPose publishedGeneral; // out/general
+    double publishedBattery{};
+    bool publishedBaseLocked{};
+    bool publishedInShadow{};
+    unsigned int publishedStorageRevision{};
+    std::string encodedPose;
 
 
     ShadowZone shadow_zone{b2Vec2{250.f, 0.f}, 45.f};
@@ -45,6 +45,7 @@ RobotArm::RobotArm(Simulation *simulation, b2Body *robotBody) : Object(simulatio
     b2FixtureDef fixdef;
 
     fixdef.filter.groupIndex = -1;
+    fixdef.filter.categoryBits = CollisionCategory::RobotPart;
     fixdef.userData.pointer = reinterpret_cast<uintptr_t>(this);
     fixdef.density = 0.5;
     fixdef.friction = 0.1;
@@ -114,6 +115,7 @@ RobotArm::RobotArm(Simulation *simulation, b2Body *robotBody) : Object(simulatio
     b2FixtureDef fixdefGripper;
 
     fixdefGripper.filter.groupIndex = -1;
+    fixdefGripper.filter.categoryBits = CollisionCategory::RobotPart;
     fixdefGripper.userData.pointer = reinterpret_cast<uintptr_t>(this);
     fixdefGripper.density = 0.5;
     fixdefGripper.friction = 0.1;
@@ -136,10 +138,12 @@ RobotArm::RobotArm(Simulation *simulation, b2Body *robotBody) : Object(simulatio
     jdGripper.localAnchorB.Set(-0.7f, 2.5f);
     world->CreateJoint(&jdGripper);
 
-    updateable = true;
+    updateable = false;
     terrain_movable = false;
+    setPublishInterval(1.0 / 20.0);
 
     name = "Robot Arm";
+    type = ObjectType::RobotArm;
 }
 void
 RobotArm::SetSpeeds(float one, float two, float three)
@@ -174,6 +178,7 @@ RobotArm::CloseGripper()
     b2FixtureDef fixdefGripper;
 
     fixdefGripper.filter.groupIndex = -1;
+    fixdefGripper.filter.categoryBits = CollisionCategory::RobotPart;
     fixdefGripper.userData.pointer = reinterpret_cast<uintptr_t>(this);
     fixdefGripper.density = 0.5;
     fixdefGripper.friction = 0.1;
@@ -225,10 +230,44 @@ RobotArm::GetJsonData()
 void
 RobotArm::update()
 {
-    if(simulation->GetStepCount() % 3 == 0)
-    {
-        Mqtt::getInstance().send("out/arm", "arm", GetJsonData());
+    // nothing, the arm is moved by its motors and only publishes
+}
+
+void
+RobotArm::publish()
+{
+    auto writer = Mqtt::getInstance().beginMessage("out/arm", "arm");
+    if (!writer) {
+        return;
     }
+
+    // Same keys as GetJsonData, in sorted order
+    writer->beginObject(11);
+    writer->key("arm1_jointAngle");
+    writer->value(joint1->GetJointAngle());
+    writer->key("arm1_jointSpeed");
+    writer->value(joint1->GetJointSpeed());
+    writer->key("arm1_motorSpeed");
+    writer->value(joint1->GetMotorSpeed());
+    writer->key("arm2_jointAngle");
+    writer->value(joint2->GetJointAngle());
+    writer->key("arm2_jointSpeed");
+    writer->value(joint2->GetJointSpeed());
+    writer->key("arm2_motorSpeed");
+    writer->value(joint2->GetMotorSpeed());
+    writer->key("arm3_jointAngle");
+    writer->value(joint3->GetJointAngle());
+    writer->key("arm3_jointSpeed");
+    writer->value(joint3->GetJointSpeed());
+    writer->key("arm3_motorSpeed");
+    writer->value(joint3->GetMotorSpeed());
+    writer->key("arm_fold_locked");
+    writer->value(IsLockFolded());
+    writer->key("arm_opened");
+    writer->value(IsGripperOpen());
+    writer->endObject();
+
+    Mqtt::getInstance().endMessage();
 }
 
 bool
@@ -36,6 +36,8 @@ public:
 
     void update() override;
 
+    void publish() override;
+
     void SetSpeeds(float one, float two, float three);
 
     void CloseGripper();
@@ -32,13 +32,12 @@
 SeismicSensor::SeismicSensor(Simulation *simulation, b2Vec2 pos) : PhysicalWeatherSensor(simulation, pos)
 {
     name = "Seismic Sensor";
+    type = ObjectType::SeismicSensor;
 }
 
-void
-SeismicSensor::update()
+float
+SeismicSensor::getShakeValue()
 {
-    g_debugDraw.DrawCircle(getPosition(), 1.f, b2Color{0.5f, 0.5f, 0.f, 1.f});
-
     static std::random_device rd;
     static std::mt19937 gen(rd());
     static std::uniform_real_distribution<> distrQuake(8.2f, 9.f);
@@ -57,27 +56,39 @@ SeismicSensor::update()
     if (simulation->earthquake.isActive()) {
         shakeValue = (float)distrQuake(gen);
 
-        b2Vec2 earthquakePos{simulation->earthquake.epiX, simulation->earthquake.epiY};
-        b2Vec2 strength{earthquakePos - getPosition()};
-        float attenuation = strength.LengthSquared();
-        attenuation /= 1.f;
-        attenuation = glm::clamp(attenuation, 0.f, 100000.f);
-        shakeValue = glm::mix(shakeValue, 0.001f, attenuation / 100000.f);
-
+        float attenuation = simulation->GetEnvironmentField().sample(getPosition()).quakeDamping;
+        shakeValue = glm::mix(shakeValue, 0.001f, attenuation);
     }
 
-    std::string str = std::to_string(shakeValue) + "'Q";
-    g_debugDraw.DrawString(getPosition(), str.c_str());
+    return shakeValue;
+}
 
-    if (simulation->GetStepCount() % updateFrequency == 0) {
-        nlohmann::json j;
+void
+SeismicSensor::publish()
+{
+    auto writer = Mqtt::getInstance().beginMessage("out/sensors", name, object_id);
+    if (!writer) {
+        return;
+    }
 
-        auto pos = getPosition();
-        j["pos"] = {{"x", pos.x}, {"y", pos.y}};
+    auto pos = getPosition();
+    writer->beginObject(3);
+    writer->key("id");
+    writer->value(object_id);
+    writer->key("pos");
+    writer->position(pos.x, pos.y);
+    writer->key("shake_val");
+    writer->value(getShakeValue());
+    writer->endObject();
+
+    Mqtt::getInstance().endMessage();
+}
 
-        j["shake_val"] = shakeValue;
-        j["id"] = object_id;
+void
+SeismicSensor::draw()
+{
+    g_debugDraw.DrawCircle(getPosition(), 1.f, b2Color{0.5f, 0.5f, 0.f, 1.f});
 
-        Mqtt::getInstance().send("out/sensors", name, j);
-    }
+    std::string str = std::to_string(getShakeValue()) + "'Q";
+    g_debugDraw.DrawString(getPosition(), str.c_str());
 }
@@ -29,7 +29,11 @@ class SeismicSensor : public PhysicalWeatherSensor
 {public:
     SeismicSensor(Simulation *simulation, b2Vec2 pos);
 
-    void update() override;
+    void publish() override;
+
+    void draw() override;
+
+    float getShakeValue();
 };
 
 #endif // MARSIM_SEISMIC_SENSOR_H
@@ -0,0 +1,136 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "sensor_frame.h"
+#include "mqtt.h"
+#include "seismic_sensor.h"
+#include "temperature_sensor.h"
+#include "wind_sensor.h"
+
+void
+SensorFrame::setKeyframeInterval(double interval)
+{
+    keyframeInterval = interval;
+}
+
+void
+SensorFrame::publish(const std::vector<PhysicalWeatherSensor *> &sensors, double time)
+{
+    auto &mqtt = Mqtt::getInstance();
+    auto writer = mqtt.beginMessage("out/sensors", "SensorFrame");
+    if (!writer) {
+        // Nobody got the positions, so whoever listens next needs all of them
+        keyframeNeeded = true;
+        return;
+    }
+
+    // Positions are sent once, so a frame another one replaced in the queue or that was thrown away took them along.
+    // Taken after beginMessage, which throws the queued frames away when the message format switches.
+    const auto discarded = mqtt.getDiscardedCount("out/sensors");
+    const bool keyframe = keyframeNeeded || lastKeyframeTime < 0.0 || time - lastKeyframeTime >= keyframeInterval ||
+                          mqtt.getTopicSetting("out/sensors").latestValue || discarded != discardedMessages;
+    discardedMessages = discarded;
+    if (keyframe) {
+        lastKeyframeTime = time;
+        keyframeNeeded = false;
+    }
+
+    positions.clear();
+    seismicSensors.clear();
+    temperatureSensors.clear();
+    windSensors.clear();
+    for (auto &&sensor : sensors) {
+        auto position = sensor->getPosition();
+        if (keyframe || !sensor->framePositionSent || (position - sensor->framePosition).Length() >= minDistance) {
+            positions.push_back({sensor->GetObjectId(), position});
+            sensor->framePosition = position;
+            sensor->framePositionSent = true;
+        }
+
+        switch (sensor->type) {
+        case ObjectType::SeismicSensor:
+            seismicSensors.push_back(static_cast<SeismicSensor *>(sensor));
+            break;
+        case ObjectType::TemperatureSensor:
+            temperatureSensors.push_back(static_cast<TemperatureSensor *>(sensor));
+            break;
+        case ObjectType::WindSensor:
+            windSensors.push_back(static_cast<WindSensor *>(sensor));
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Writes one column, a value per element of the list
+    auto writeColumn = [&](const char *key, const auto &list, auto &&getValue) {
+        writer->key(key);
+        writer->beginArray(list.size());
+        for (auto &&element : list) {
+            writer->value(getValue(element));
+        }
+        writer->endArray();
+    };
+    auto getId = [](auto *sensor) { return sensor->GetObjectId(); };
+
+    writer->beginObject(6);
+    writer->key("keyframe");
+    writer->value(keyframe);
+
+    writer->key("positions");
+    writer->beginObject(3);
+    writeColumn("id", positions, [](const Position &p) { return p.id; });
+    writeColumn("x", positions, [](const Position &p) { return p.position.x; });
+    writeColumn("y", positions, [](const Position &p) { return p.position.y; });
+    writer->endObject();
+
+    writer->key("schema");
+    writer->value(schema);
+
+    writer->key("seismic");
+    writer->beginObject(2);
+    writeColumn("id", seismicSensors, getId);
+    writeColumn("shake_val", seismicSensors, [](SeismicSensor *sensor) { return sensor->getShakeValue(); });
+    writer->endObject();
+
+    writer->key("temperature");
+    writer->beginObject(2);
+    writeColumn("id", temperatureSensors, getId);
+    writeColumn("temp", temperatureSensors, [](TemperatureSensor *sensor) { return sensor->getTemperature(); });
+    writer->endObject();
+
+    // The wind is sampled once per sensor for both columns
+    writer->key("wind");
+    writer->beginObject(3);
+    writeColumn("id", windSensors, getId);
+    winds.clear();
+    for (auto &&sensor : windSensors) {
+        winds.push_back(sensor->getWind());
+    }
+    writeColumn("wind_x", winds, [](const b2Vec2 &wind) { return wind.x; });
+    writeColumn("wind_y", winds, [](const b2Vec2 &wind) { return wind.y; });
+    writer->endObject();
+
+    writer->endObject();
+
+    mqtt.endMessage();
+}
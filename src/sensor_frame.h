@@ -0,0 +1,81 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_SENSOR_FRAME_H
+#define MARSIM_SENSOR_FRAME_H
+
+#include "box2d/b2_math.h"
+
+#include <vector>
+
+class PhysicalWeatherSensor;
+class SeismicSensor;
+class TemperatureSensor;
+class WindSensor;
+
+// All weather sensors in one message on out/sensors, as a column per field of each sensor type:
+//
+//   {"keyframe": bool,
+//    "positions": {"id": [...], "x": [...], "y": [...]},
+//    "schema": 1,
+//    "seismic": {"id": [...], "shake_val": [...]},
+//    "temperature": {"id": [...], "temp": [...]},
+//    "wind": {"id": [...], "wind_x": [...], "wind_y": [...]}}
+//
+// Positions are only sent for sensors that are new or were moved, except in keyframes, which have all of them. A
+// keyframe follows every frame that was thrown away before it left the simulator, and with latestValue on the topic
+// every frame is one, since the queue keeps only the last.
+// The schema changes whenever the layout does.
+class SensorFrame
+{
+public:
+    static constexpr int schema = 1;
+
+    void setKeyframeInterval(double interval);
+
+    // Time is the simulated time in seconds
+    void publish(const std::vector<PhysicalWeatherSensor *> &sensors, double time);
+
+private:
+    struct Position
+    {
+        unsigned int id;
+        b2Vec2 position;
+    };
+
+    // Meters a sensor moves before its position is sent again
+    static constexpr float minDistance = 0.01f;
+
+    double keyframeInterval{10.0};
+    double lastKeyframeTime{-1.0};
+    bool keyframeNeeded{true};
+    unsigned int discardedMessages{0};
+
+    // Reused by every publish
+    std::vector<Position> positions;
+    std::vector<SeismicSensor *> seismicSensors;
+    std::vector<TemperatureSensor *> temperatureSensors;
+    std::vector<WindSensor *> windSensors;
+    std::vector<b2Vec2> winds;
+};
+
+#endif // MARSIM_SENSOR_FRAME_H
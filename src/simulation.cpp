@@ -23,6 +23,7 @@
 #include "simulation.h"
 #include "alien.h"
 #include "framework/application.h"
+#include "framework/settings.h"
 #include "friction_zone.h"
 #include "mqtt.h"
 #include "proximity_sensor.h"
@@ -34,6 +35,7 @@
 #include "volcano.h"
 #include "wind_sensor.h"
 #include <algorithm>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -45,6 +47,8 @@ Simulation::Simulation(const SimulationSetup &setup) : earthquake{m_world, this}
 
     this->setup = setup;
 
+    startTimePoint = std::chrono::system_clock::now();
+
     srand(setup.simulationSeed);
 
     std::random_device rd;
@@ -65,6 +69,12 @@ Simulation::Simulation(const SimulationSetup &setup) : earthquake{m_world, this}
 
     shadow_zone = new ShadowZone({setup.shadowFrontierX, setup.shadowFrontierY}, setup.shadowFrontierR);
 
+    worldState.configure(setup.worldStateCellSize,
+                         setup.worldStateRadius,
+                         setup.worldStateMinDistance,
+                         setup.worldStateMinAngle,
+                         setup.worldStateKeyframeInterval);
+
     robot = new Robot{this, 2.f, 3.f, b2Vec2{setup.robotX, setup.robotY}, setup.robotR, 480.f, 150.f};
     auto wheels = std::vector<Wheel *>{new Wheel{this, robot, -1.5f, 0.0f, 0.5f, 0.5f},
                                        new Wheel{this, robot, 1.5f, 0.0f, 0.5f, 0.5f}};
@@ -78,6 +88,13 @@ Simulation::Simulation(const SimulationSetup &setup) : earthquake{m_world, this}
     std::uniform_real_distribution<> distrY(setup.objectGenerationMinY * imageScaleFactorMultiplier,
                                             setup.objectGenerationMaxY * imageScaleFactorMultiplier);
     std::uniform_real_distribution<> distrR(1.f, 3.f);
+
+    // The field covers the area objects are generated in, with some margin for sensors that are pushed around
+    constexpr float environmentFieldMargin = 50.f;
+    environmentField.resize({(float)distrX.min() - environmentFieldMargin, (float)distrY.min() - environmentFieldMargin},
+                            {(float)distrX.max() + environmentFieldMargin, (float)distrY.max() + environmentFieldMargin},
+                            setup.environmentFieldCellSize);
+
     for (int i = 0; i < setup.stonesAmount; i++) {
         auto *stone = new Stone{this, {(float)distrX(gen), (float)distrY(gen)}, (float)distrR(gen)};
         SimulateObject(stone);
@@ -121,6 +138,30 @@ Simulation::Simulation(const SimulationSetup &setup) : earthquake{m_world, this}
         AddObjectFromJson(object);
     }
 
+    // Broadcast general info every 5 seconds
+    Schedule(5.0, [this] { BroadcastGeneralInfo(); });
+
+    if (setup.environmentFieldMapInterval > 0.f) {
+        Schedule(setup.environmentFieldMapInterval, [this] {
+            Mqtt::getInstance().send("out/fields", "environment field", environmentField.getJson());
+        });
+    }
+
+    if (setup.worldStateInterval > 0.f) {
+        Schedule(setup.worldStateInterval, [this] { worldState.publish(robot->getPosition(), GetSimulationTime()); });
+    }
+
+    if (setup.sensorFrameInterval > 0.f) {
+        sensorFrame.setKeyframeInterval(setup.sensorFrameKeyframeInterval);
+        Schedule(setup.sensorFrameInterval, [this] { sensorFrame.publish(weatherSensors, GetSimulationTime()); });
+    }
+
+    Mqtt::getInstance().setCompressionCpuBudget(setup.compressionCpuBudget);
+    Mqtt::getInstance().resetTopicSettings();
+    for (auto &&[topic, topicSetting] : setup.topicSettings) {
+        Mqtt::getInstance().overrideTopicSettings(topic, topicSetting);
+    }
+
     TopicSetting ts;
     ts.waitForMQTTConnection = true;
     ts.retained = true;
@@ -178,6 +219,98 @@ Simulation::Create(const std::string &initJson)
             setup.objectGenerationMaxX = j["objectGenerationMaxX"];
             setup.objectGenerationMinY = j["objectGenerationMinY"];
             setup.objectGenerationMaxY = j["objectGenerationMaxY"];
+            if (j.contains("lidarAngularResolution")) {
+                setup.lidarAngularResolution = j["lidarAngularResolution"];
+            }
+            if (j.contains("lidarFrequency")) {
+                setup.lidarFrequency = j["lidarFrequency"];
+            }
+            if (j.contains("slopeFrictionThreshold")) {
+                setup.slopeFrictionThreshold = j["slopeFrictionThreshold"];
+            }
+            if (j.contains("environmentFieldCellSize")) {
+                setup.environmentFieldCellSize = j["environmentFieldCellSize"];
+            }
+            if (j.contains("environmentFieldMapInterval")) {
+                setup.environmentFieldMapInterval = j["environmentFieldMapInterval"];
+            }
+            if (j.contains("compressionCpuBudget")) {
+                setup.compressionCpuBudget = j["compressionCpuBudget"];
+            }
+            if (j.contains("poseMinDistance")) {
+                setup.poseMinDistance = j["poseMinDistance"];
+            }
+            if (j.contains("poseMinAngle")) {
+                setup.poseMinAngle = j["poseMinAngle"];
+            }
+            if (j.contains("poseKeyframeInterval")) {
+                setup.poseKeyframeInterval = j["poseKeyframeInterval"];
+            }
+            if (j.contains("worldStateInterval")) {
+                setup.worldStateInterval = j["worldStateInterval"];
+            }
+            if (j.contains("worldStateRadius")) {
+                setup.worldStateRadius = j["worldStateRadius"];
+            }
+            if (j.contains("worldStateCellSize")) {
+                setup.worldStateCellSize = j["worldStateCellSize"];
+            }
+            if (j.contains("worldStateMinDistance")) {
+                setup.worldStateMinDistance = j["worldStateMinDistance"];
+            }
+            if (j.contains("worldStateMinAngle")) {
+                setup.worldStateMinAngle = j["worldStateMinAngle"];
+            }
+            if (j.contains("worldStateKeyframeInterval")) {
+                setup.worldStateKeyframeInterval = j["worldStateKeyframeInterval"];
+            }
+            if (j.contains("sensorFrameInterval")) {
+                setup.sensorFrameInterval = j["sensorFrameInterval"];
+            }
+            if (j.contains("sensorFrameKeyframeInterval")) {
+                setup.sensorFrameKeyframeInterval = j["sensorFrameKeyframeInterval"];
+            }
+            if (j.contains("topicSettings")) {
+                for (auto &&[topic, policy] : j["topicSettings"].items()) {
+                    TopicSetting ts;
+                    if (policy.contains("retained")) {
+                        ts.retained = policy["retained"];
+                    }
+                    if (policy.contains("waitForMQTTConnection")) {
+                        ts.waitForMQTTConnection = policy["waitForMQTTConnection"];
+                    }
+                    if (policy.contains("maxMessages")) {
+                        ts.maxMessages = policy["maxMessages"];
+                    }
+                    if (policy.contains("latestValue")) {
+                        ts.latestValue = policy["latestValue"];
+                    }
+                    if (policy.contains("maxRate")) {
+                        ts.maxRate = policy["maxRate"];
+                    }
+                    if (policy.contains("coalesceWindow")) {
+                        ts.coalesceWindow = policy["coalesceWindow"];
+                    }
+                    if (policy.contains("compact")) {
+                        ts.compact = policy["compact"];
+                    }
+                    if (policy.contains("keyframeInterval")) {
+                        ts.keyframeInterval = policy["keyframeInterval"];
+                    }
+                    if (policy.contains("priority")) {
+                        const std::string priority = policy["priority"];
+                        if (priority == "high") {
+                            ts.priority = TopicPriority::High;
+                        } else if (priority == "low") {
+                            ts.priority = TopicPriority::Low;
+                        } else if (priority != "normal") {
+                            std::cerr << "Unknown priority " << priority << " of topic " << topic
+                                      << ", it should be high, normal or low." << std::endl;
+                        }
+                    }
+                    setup.topicSettings.emplace_back(topic, ts);
+                }
+            }
         } catch (std::exception &e) {
             std::cerr << "Failed to parse init.json file: " << e.what() << "\nUsing default simulator settings!"
                       << std::endl;
@@ -193,11 +326,23 @@ Simulation::Create(const std::string &initJson)
 
 Simulation::~Simulation()
 {
+    // Everything goes at once, so objects do not need to take themselves out of the lists one by one, and the arena
+    // drops its pages whole instead of taking every block back on a free list. The destructors still run for the
+    // memory objects hold outside of the arena. Their bodies go with the world.
+    scheduler.clear();
+    querySensors.clear();
+    Arena::beginTeardown();
+
     for (auto &&object : objects) {
         delete object;
     }
 
-    objects = {};
+    objects.clear();
+
+    // Wait for a terrain still being generated in the background
+    if (regeneratedTerrain.valid()) {
+        delete regeneratedTerrain.get();
+    }
 
     delete terrain;
     delete shadow_zone;
@@ -211,62 +356,95 @@ Simulation::UpdateObjects()
     tornadoDatas.clear();
     alienDatas.clear();
 
-    for (auto &&object : objects) {
-        if (auto tornado = dynamic_cast<Tornado *>(object)) {
-            tornadoDatas.push_back({tornado->getPosition(), tornado->magnitude, tornado->radius});
-        }
+    for (auto &&tornado : tornadoes) {
+        tornadoDatas.push_back({tornado->getPosition(), tornado->magnitude, tornado->radius});
+    }
 
-        if (auto alien = dynamic_cast<Alien *>(object)) {
-            alienDatas.push_back({alien->getPosition()});
-        }
+    for (auto &&alien : aliens) {
+        alienDatas.push_back({alien->getPosition()});
+    }
 
-        if (auto volcano = dynamic_cast<Volcano *>(object)) {
-            volcanoDatas.push_back({volcano->getPosition()});
-        }
+    // Only the volcano that can erupt heats up its surroundings
+    if (volcano) {
+        volcanoDatas.push_back({volcano->getPosition(), volcano->magnitude, volcano->radius});
     }
+    float volcanoTemperature = volcano && volcano->isActive() ? 850.f : 100.f;
+    environmentField.update(tornadoDatas,
+                            alienDatas,
+                            volcanoDatas,
+                            volcanoTemperature,
+                            earthquake.isActive(),
+                            {earthquake.epiX, earthquake.epiY});
 
-    for (auto &&object : objects) {
-        if (object->updateable) {
-            object->update();
-        }
+    for (auto &&object : updateableObjects) {
+        object->update();
+    }
+
+    // Nothing is due while paused
+    if (GetTimeStep() > 0.f) {
+        scheduler.advance(GetSimulationTime());
+    }
+}
+
+void
+Simulation::DrawObjects()
+{
+    for (auto &&object : drawableObjects) {
+        object->draw();
     }
 }
 
 void
 Simulation::ApplySlopeForce()
 {
+    const auto width = (float)terrain->getTextureWidth();
+    const auto height = (float)terrain->getTextureHeight();
+
+    slopeObjects.clear();
+    slopeXs.clear();
+    slopeYs.clear();
+
     for (auto &&object : objects) {
-        if (!object->terrain_movable) {
+        // Sleeping bodies rest in equilibrium, they are woken by contacts, explosions and terrain changes
+        if (!object->body->IsAwake()) {
             continue;
         }
 
-        auto width = (float)terrain->getTextureWidth();
-        auto height = (float)terrain->getTextureHeight();
-
-        auto robotPos = object->getPosition();
-        b2Vec2 terrainPixelPos = {robotPos.x + width / 2.f, height / 2.f - robotPos.y};
-
-        float x = terrainPixelPos.x;
-        float y = terrainPixelPos.y;
-
-        float slopeX =
-            terrain->getHeight(x < width - 1.f ? x + 1.f : x, y) - terrain->getHeight(x > 0.f ? x - 1.f : x, y);
-        float slopeZ =
-            terrain->getHeight(x, y < height - 1.f ? y + 1.f : y) - terrain->getHeight(x, y > 0.f ? y - 1.f : y);
+        // Only awake bodies can have moved to another cell of the world state
+        worldState.markAwake(object);
 
-        if (x == 0 || x == width - 1) {
-            slopeX *= 2;
+        if (!object->terrain_movable) {
+            continue;
         }
 
-        if (y == 0 || y == height - 1) {
-            slopeZ *= 2;
-        }
+        auto position = object->getPosition();
+        slopeObjects.push_back(object);
+        slopeXs.push_back(position.x + width / 2.f);
+        slopeYs.push_back(height / 2.f - position.y);
+    }
+
+    // Sample the gradients of all movable objects in one batch
+    slopeGradientXs.resize(slopeObjects.size());
+    slopeGradientYs.resize(slopeObjects.size());
+    terrain->sampleGradients(
+        slopeXs.data(), slopeYs.data(), slopeGradientXs.data(), slopeGradientYs.data(), (int)slopeObjects.size());
 
-        glm::vec3 slopeDir = {-slopeX * (width - 1), (width - 1), slopeZ * (height - 1)};
+    for (size_t i = 0; i < slopeObjects.size(); i++) {
+        glm::vec3 slopeDir = {-slopeGradientXs[i] * (width - 1), (width - 1), slopeGradientYs[i] * (height - 1)};
 
         if (glm::abs(slopeDir.x) > 0.1f || glm::abs(slopeDir.z) > 0.1f) {
             slopeDir *= 0.2f; // constant that seems to work
-            object->addForce(b2Vec2{slopeDir.x, slopeDir.z});
+            b2Vec2 force{slopeDir.x, slopeDir.z};
+
+            // Static friction holds a body that is nearly at rest on gentle slopes, so it can fall asleep. Moving
+            // bodies keep sliding down.
+            auto velocity = slopeObjects[i]->body->GetLinearVelocity();
+            if (velocity.LengthSquared() < b2_linearSleepTolerance * b2_linearSleepTolerance &&
+                force.Length() <= setup.slopeFrictionThreshold * slopeObjects[i]->GetMass()) {
+                continue;
+            }
+
+            slopeObjects[i]->addForce(force, false);
         }
     }
 }
@@ -274,6 +452,11 @@ Simulation::ApplySlopeForce()
 void
 Simulation::Step(Settings &settings)
 {
+    // Control messages received by the MQTT thread since the last step
+    Mqtt::getInstance().receiveQueuedMessages();
+
+    CollectRegeneratedTerrain();
+
     g_debugDraw.DrawImageTexture(
         terrain->getTextureID(), {0.f, 0.f}, {(float)terrain->getTextureWidth(), (float)terrain->getTextureHeight()});
 
@@ -281,58 +464,68 @@ Simulation::Step(Settings &settings)
 
     earthquake.update(m_stepCount);
 
+    // One slot of the scheduler per step
+    if (settings.m_hertz > 0.f) {
+        scheduler.setSlotDuration(1.0 / settings.m_hertz);
+    }
+
     UpdateObjects();
 
+    if (settings.m_drawShapes) {
+        DrawObjects();
+    }
+
     for (auto &&object : objectsSpawned) {
         SimulateObject(object);
     }
     objectsSpawned.clear();
 
-    for (auto &&object : objectsDestroyed) {
-        DestroyObject(object);
+    // Objects can be queued more than once, for example hit by the laser and picked up in the same step
+    for (auto &&handle : objectsDestroyed) {
+        if (auto object = GetObjectByHandle(handle)) {
+            DestroyObject(object);
+        }
     }
 
     objectsDestroyed.clear();
 
     ApplySlopeForce();
 
-    BroadcastGeneralInfo();
-
     Application::Step(settings);
 }
 
+// Keys are GLFW key codes, which for printable keys are the same as their upper case ASCII values.
 void
 Simulation::Keyboard(int key)
 {
-
-    if (key == GLFW_KEY_W) {
+    if (key == 'W') {
         robot->leftAccelerate = 1.f;
-    } else if (key == GLFW_KEY_S) {
+    } else if (key == 'S') {
         robot->leftAccelerate = -1.f;
     }
 
-    if (key == GLFW_KEY_E) {
+    if (key == 'E') {
         robot->rightAccelerate = 1.f;
-    } else if (key == GLFW_KEY_D) {
+    } else if (key == 'D') {
         robot->rightAccelerate = -1.f;
     }
 }
 void
 Simulation::KeyboardUp(int key)
 {
-    if (key == GLFW_KEY_W || key == GLFW_KEY_S) {
+    if (key == 'W' || key == 'S') {
         robot->leftAccelerate = 0.f;
     }
 
-    if (key == GLFW_KEY_E || key == GLFW_KEY_D) {
+    if (key == 'E' || key == 'D') {
         robot->rightAccelerate = 0.f;
     }
 
-    if (key == GLFW_KEY_F) {
+    if (key == 'F') {
         earthquake.trigger(50.f, 500, 0.f, 0.f);
     }
 
-    if (key == GLFW_KEY_V) {
+    if (key == 'V') {
         volcano->trigger(3500.f, 500);
     }
 }
@@ -340,22 +533,92 @@ void
 
 Simulation::SimulateObject(Object *object)
 {
-    objects.push_back(object);
+    object->handle = objects.insert(object);
+    objectIds[object->GetObjectId()] = object->handle;
+    worldState.add(object);
+
+    // Objects decide in their constructor whether they are updated, so the list is only built here
+    if (object->updateable) {
+        object->updateHandle = updateableObjects.insert(object);
+    }
+    if (object->drawable) {
+        object->drawHandle = drawableObjects.insert(object);
+    }
+
+    switch (object->type) {
+    case ObjectType::Tornado:
+        tornadoes.push_back(static_cast<Tornado *>(object));
+        break;
+    case ObjectType::Alien:
+        aliens.push_back(static_cast<Alien *>(object));
+        break;
+    case ObjectType::WindSensor:
+    case ObjectType::SeismicSensor:
+    case ObjectType::TemperatureSensor:
+        weatherSensors.push_back(static_cast<PhysicalWeatherSensor *>(object));
+        break;
+    default:
+        break;
+    }
+}
+
+void
+Simulation::UnlistObject(Object *object)
+{
+    auto unlist = [](auto &list, auto *item) {
+        auto it = std::find(list.begin(), list.end(), item);
+        if (it != list.end()) {
+            list.erase(it);
+        }
+    };
+
+    objects.erase(object->handle);
+    updateableObjects.erase(object->updateHandle);
+    drawableObjects.erase(object->drawHandle);
+    worldState.remove(object);
+
+    // A dropped item can reuse the id of an object that is destroyed in the same step
+    auto id = objectIds.find(object->GetObjectId());
+    if (id != objectIds.end() && id->second == object->handle) {
+        objectIds.erase(id);
+    }
+
+    object->handle = {};
+    object->updateHandle = {};
+    object->drawHandle = {};
+
+    switch (object->type) {
+    case ObjectType::Tornado:
+        unlist(tornadoes, static_cast<Tornado *>(object));
+        break;
+    case ObjectType::Alien:
+        unlist(aliens, static_cast<Alien *>(object));
+        break;
+    case ObjectType::WindSensor:
+    case ObjectType::SeismicSensor:
+    case ObjectType::TemperatureSensor:
+        unlist(weatherSensors, static_cast<PhysicalWeatherSensor *>(object));
+        break;
+    default:
+        break;
+    }
 }
 
 void
 Simulation::DestroyObject(Object *object)
 {
-    auto it = std::find(objects.begin(), objects.end(), object);
-    if (it != objects.end()) {
-        objects.erase(it);
+    // Query based sensors have no contacts that end with the body
+    for (auto &&sensor : querySensors) {
+        sensor->ObjectDestroyed(object);
+        for (auto &&attachedObject : object->getAttachedObjects()) {
+            sensor->ObjectDestroyed(attachedObject);
+        }
     }
 
+    UnlistObject(object);
+
     for (auto &&attachedObject : object->getAttachedObjects()) {
-        auto it2 = std::find(objects.begin(), objects.end(), attachedObject);
-        if (it2 != objects.end()) {
-            objects.erase(it2);
-        }
+        UnlistObject(attachedObject);
 
         m_world->DestroyBody(attachedObject->body);
         delete attachedObject;
@@ -376,14 +639,15 @@ Simulation::BeginContact(b2Contact *contact)
     auto *a = reinterpret_cast<Object *>(fixtureA->GetUserData().pointer);
     auto *b = reinterpret_cast<Object *>(fixtureB->GetUserData().pointer);
 
-    if (auto sensor = dynamic_cast<ProximitySensor *>(a)) {
+    // Only proximity sensors use the sensor category
+    if (fixtureA->GetFilterData().categoryBits & CollisionCategory::Sensor) {
         // std::cout << "COLLIDE WITH SENSOR A " << b->name << std::endl;
-        sensor->ObjectEnter(b);
+        static_cast<ProximitySensor *>(a)->ObjectEnter(b);
     }
 
-    if (auto sensor = dynamic_cast<ProximitySensor *>(b)) {
+    if (fixtureB->GetFilterData().categoryBits & CollisionCategory::Sensor) {
         // std::cout << "COLLIDE WITH SENSOR B " << a->name << std::endl;
-        sensor->ObjectEnter(a);
+        static_cast<ProximitySensor *>(b)->ObjectEnter(a);
     }
 }
 
@@ -396,14 +660,15 @@ Simulation::EndContact(b2Contact *contact)
     auto *a = reinterpret_cast<Object *>(fixtureA->GetUserData().pointer);
     auto *b = reinterpret_cast<Object *>(fixtureB->GetUserData().pointer);
 
-    if (auto sensor = dynamic_cast<ProximitySensor *>(a)) {
+    // Only proximity sensors use the sensor category
+    if (fixtureA->GetFilterData().categoryBits & CollisionCategory::Sensor) {
         // std::cout << "LEAVE SENSOR A " << b->name << std::endl;
-        sensor->ObjectLeave(b);
+        static_cast<ProximitySensor *>(a)->ObjectLeave(b);
     }
 
-    if (auto sensor = dynamic_cast<ProximitySensor *>(b)) {
+    if (fixtureB->GetFilterData().categoryBits & CollisionCategory::Sensor) {
         // std::cout << "LEAVE SENSOR B " << a->name << std::endl;
-        sensor->ObjectLeave(a);
+        static_cast<ProximitySensor *>(b)->ObjectLeave(a);
     }
 }
 Robot *
@@ -412,6 +677,27 @@ Simulation::GetRobot()
     return robot;
 }
 
+Arena::Stats
+Simulation::GetArenaStats()
+{
+    return getStats();
+}
+
+void
+Simulation::AddQuerySensor(ProximitySensor *sensor)
+{
+    querySensors.push_back(sensor);
+}
+
+void
+Simulation::RemoveQuerySensor(ProximitySensor *sensor)
+{
+    auto it = std::find(querySensors.begin(), querySensors.end(), sensor);
+    if (it != querySensors.end()) {
+        querySensors.erase(it);
+    }
+}
+
 b2World *
 Simulation::GetWorld()
 {
@@ -422,6 +708,47 @@ Simulation::GetStepCount()
 {
     return m_stepCount;
 }
+
+double
+Simulation::GetSimulationTime()
+{
+    return m_simulationTime;
+}
+
+float
+Simulation::GetTimeStep()
+{
+    return m_lastTimeStep;
+}
+
+std::chrono::system_clock::time_point
+Simulation::GetSimulationTimePoint()
+{
+    return startTimePoint +
+           std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::duration<double>(m_simulationTime));
+}
+
+SlotHandle
+Simulation::Schedule(double interval, UpdateScheduler::Job job)
+{
+    return scheduler.add(interval, std::move(job));
+}
+
+void
+Simulation::Unschedule(SlotHandle handle)
+{
+    scheduler.remove(handle);
+}
+
+bool
+Simulation::IsIntervalDue(double interval)
+{
+    if (m_lastTimeStep <= 0.f) {
+        return false;
+    }
+
+    return std::floor(m_simulationTime / interval) > std::floor((m_simulationTime - m_lastTimeStep) / interval);
+}
 void
 Simulation::WakeAllObjects()
 {
@@ -437,24 +764,77 @@ Simulation::GetTerrain()
 void
 Simulation::GenerateBlurredTerrain()
 {
-
-    if (terrain) {
-        delete terrain;
-    }
+    Terrain *newTerrain{nullptr};
 
     if (std::filesystem::exists("data/lunar_received.png")) {
         // If there is a received lunar image, use this instead
         std::cout << "Using provided received lunar image." << std::endl;
-        Terrain::GenerateGaussianImageFromHardEdgeImage("data/lunar_received.png", "data/lunar_blurred.png", 1.2f);
 
-        terrain = new Terrain{"data/lunar_blurred.png"};
-    } else {
+        std::ifstream image_file("data/lunar_received.png", std::ios::binary);
+        std::vector<unsigned char> encodedImage((std::istreambuf_iterator<char>(image_file)),
+                                                std::istreambuf_iterator<char>());
+
+        newTerrain = Terrain::CreateFromHardEdgeImage(encodedImage, 1.2f, "data/lunar_blurred.png");
+    }
+
+    if (!newTerrain) {
         // Default using raw satellite image
         std::cout << "No received lunar image found, using raw satellite image." << std::endl;
 
-        terrain = new Terrain{Mqtt::requestImagePath};
+        newTerrain = new Terrain{Mqtt::requestImagePath};
     }
 
+    SwapTerrain(newTerrain);
+}
+
+void
+Simulation::RegenerateTerrainAsync(std::vector<unsigned char> encodedImage)
+{
+    if (regeneratedTerrain.valid()) {
+        queuedTerrainImage = std::move(encodedImage);
+        return;
+    }
+
+    regeneratedTerrain = std::async(std::launch::async, [encodedImage = std::move(encodedImage)]() {
+        // Keep the received image, so the next start of the simulator uses it too
+        std::ofstream image_file("data/lunar_received.png", std::ios::binary);
+        image_file.write(reinterpret_cast<const char *>(encodedImage.data()), encodedImage.size());
+        image_file.close();
+
+        return Terrain::CreateFromHardEdgeImage(encodedImage, 1.2f, "data/lunar_blurred.png");
+    });
+}
+
+void
+Simulation::CollectRegeneratedTerrain()
+{
+    if (!regeneratedTerrain.valid() ||
+        regeneratedTerrain.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+
+    SwapTerrain(regeneratedTerrain.get());
+    std::cout << "Regenerated blurred terrain." << std::endl;
+
+    if (!queuedTerrainImage.empty()) {
+        RegenerateTerrainAsync(std::move(queuedTerrainImage));
+        queuedTerrainImage.clear();
+    }
+}
+
+void
+Simulation::SwapTerrain(Terrain *newTerrain)
+{
+    if (!newTerrain) {
+        return;
+    }
+
+    delete terrain;
+    terrain = newTerrain;
+    terrain->uploadTexture();
+
+    // Resting bodies have to find their new equilibrium on the changed slopes
+    WakeAllObjects();
 }
 
 std::vector<TornadoData> &
@@ -469,34 +849,25 @@ Simulation::GetAliens()
     return alienDatas;
 }
 
-std::vector<VolcanoData>
-Simulation::GetVolcanoes() const
+const EnvironmentField &
+Simulation::GetEnvironmentField()
 {
-    if(!volcano)
-    {
-        return {};
-    }
-    std::vector<VolcanoData> vds;
-    VolcanoData vd{};
-    vd.magnitude = volcano->magnitude;
-    vd.radius = volcano->radius;
-    vd.pos = volcano->getPosition();
-    vds.push_back(vd);
-    return vds;
+    return environmentField;
+}
+
+std::vector<VolcanoData> &
+Simulation::GetVolcanoes()
+{
+    return volcanoDatas;
 }
 
 void
 Simulation::BroadcastGeneralInfo()
 {
-    static unsigned int i = 0;
-    i++;
-
-    // Broadcast general info every 5 seconds
-    if (i % 300 == 0) {
-        nlohmann::json j = GetGeneralInfo();
-        Mqtt::getInstance().send("out/info", "info", j);
-    }
+    nlohmann::json j = GetGeneralInfo();
+    Mqtt::getInstance().send("out/info", "info", j);
 }
+
 void
 Simulation::SimulateObjectNextFrame(Object *object)
 {
@@ -506,7 +877,22 @@ Simulation::SimulateObjectNextFrame(Object *object)
 void
 Simulation::DestroyObjectNextFrame(Object *object)
 {
-    objectsDestroyed.push_back(object);
+    // Objects that are not simulated yet have no handle and are not destroyed
+    objectsDestroyed.push_back(object->handle);
+}
+
+Object *
+Simulation::GetObjectByHandle(SlotHandle handle)
+{
+    auto object = objects.get(handle);
+    return object ? *object : nullptr;
+}
+
+Object *
+Simulation::FindObject(unsigned int id)
+{
+    auto it = objectIds.find(id);
+    return it != objectIds.end() ? GetObjectByHandle(it->second) : nullptr;
 }
 
 nlohmann::json
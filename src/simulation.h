@@ -23,15 +23,28 @@
 #ifndef SIMULATION_H
 #define SIMULATION_H
 
+#include "arena.h"
 #include "earthquake.h"
+#include "environment_field.h"
 #include "framework/application.h"
 #include "json.hpp"
+#include "mqtt.h"
+#include "sensor_frame.h"
+#include "slot_map.h"
 #include "terrain.h"
+#include "update_scheduler.h"
+#include "world_state.h"
 
-#include <GLFW/glfw3.h>
+#include <chrono>
+#include <future>
+#include <unordered_map>
 
 class Object;
 class Robot;
+class Alien;
+class PhysicalWeatherSensor;
+class ProximitySensor;
+class Tornado;
 class Volcano;
 class ShadowZone;
 
@@ -63,25 +76,27 @@ struct SimulationSetup {
     float objectGenerationMaxX{369.f};
     float objectGenerationMinY{-205.f};
     float objectGenerationMaxY{205.f};
+    float lidarAngularResolution{1.f}; // degrees between rays
+    float lidarFrequency{2.f};         // scans published per simulated second
+    float slopeFrictionThreshold{1.f}; // slope acceleration (m/s^2) that holds bodies at rest, letting them sleep
+    float environmentFieldCellSize{4.f};    // meters between the points of the temperature and wind grids
+    float environmentFieldMapInterval{0.f}; // seconds between published field maps, 0 to not publish them
+    std::vector<std::pair<std::string, TopicSetting>> topicSettings; // delivery policies of outgoing topics
+    float compressionCpuBudget{0.05f}; // fraction of wall time the MQTT thread may spend compressing
+    float poseMinDistance{0.01f};      // meters the robot moves before its pose is published again
+    float poseMinAngle{0.5f};          // degrees the robot turns before its pose is published again
+    float poseKeyframeInterval{1.f};   // seconds after which an unchanged pose is published anyway
+    float worldStateInterval{0.1f};    // seconds between world state updates around the robot, 0 to not publish them
+    float worldStateRadius{60.f};      // meters around the robot that the world state covers
+    float worldStateCellSize{16.f};    // meters between the cells of the grid that the world state keeps objects in
+    float worldStateMinDistance{0.05f}; // meters an object moves before it is sent again
+    float worldStateMinAngle{2.f};     // degrees an object turns before it is sent again
+    float worldStateKeyframeInterval{10.f}; // seconds between world states that send every object in range
+    float sensorFrameInterval{0.f};    // seconds between frames of all weather sensors, 0 to publish them one by one
+    float sensorFrameKeyframeInterval{10.f}; // seconds between sensor frames that send every position
 };
 
-struct TornadoData {
-    b2Vec2 pos;
-    float magnitude;
-    float radius;
-};
-
-struct VolcanoData {
-    b2Vec2 pos;
-    float magnitude;
-    float radius;
-};
-
-struct AlienData {
-    b2Vec2 pos;
-};
-
-class Simulation : public Application
+class Simulation : private Arena, public Application
 {
 public:
     Simulation(const SimulationSetup &setup);
@@ -90,6 +105,8 @@ public:
 
     void UpdateObjects();
 
+    void DrawObjects();
+
     void WakeAllObjects();
 
     void ApplySlopeForce();
@@ -104,15 +121,28 @@ public:
 
     void DestroyObjectNextFrame(Object* object);
 
+    // Null if the object has been destroyed
+    Object *GetObjectByHandle(SlotHandle handle);
+
+    // Finds a simulated object by its id, null if there is none
+    Object *FindObject(unsigned int id);
+
     void GenerateBlurredTerrain();
 
+    // Builds a blurred terrain from an encoded hard edge image on a background thread. The new terrain replaces the
+    // current one at the start of the first step after it is done. Images arriving meanwhile replace each other.
+    void RegenerateTerrainAsync(std::vector<unsigned char> encodedImage);
+
     void BroadcastGeneralInfo();
 
     std::vector<TornadoData> &GetTornados();
 
     std::vector<AlienData> &GetAliens();
 
-    [[nodiscard]] std::vector<VolcanoData> GetVolcanoes() const;
+    std::vector<VolcanoData> &GetVolcanoes();
+
+    // Temperature, wind and earthquake damping of the current step, for the weather sensors to sample
+    const EnvironmentField &GetEnvironmentField();
 
     b2World *GetWorld();
 
@@ -126,8 +156,35 @@ public:
 
     int32 GetStepCount();
 
+    // Simulated seconds since the simulation started
+    double GetSimulationTime();
+
+    // Simulated seconds advanced by the last step, 0 while paused
+    float GetTimeStep();
+
+    // Wall clock time at simulation start, advanced by the simulated time
+    std::chrono::system_clock::time_point GetSimulationTimePoint();
+
+    // True on the step where the simulated time passed a multiple of the interval (seconds)
+    bool IsIntervalDue(double interval);
+
+    // Runs the job every interval seconds of simulated time, after the objects are updated. Jobs with the same
+    // interval are spread over different steps.
+    SlotHandle Schedule(double interval, UpdateScheduler::Job job);
+
+    // Does nothing for stale or empty handles
+    void Unschedule(SlotHandle handle);
+
     Robot *GetRobot();
 
+    // Allocation counters of the arena that holds the objects and the physics world
+    Arena::Stats GetArenaStats();
+
+    // Query based proximity sensors register themselves to be told about destroyed objects
+    void AddQuerySensor(ProximitySensor *sensor);
+
+    void RemoveQuerySensor(ProximitySensor *sensor);
+
     Earthquake earthquake;
 
     Volcano *volcano{};
@@ -136,10 +193,6 @@ public:
 
     SimulationSetup setup;
 
-    static inline GLFWwindow* window;
-
-    static inline Camera* camera;
-
 private:
 
     void AddObjectFromJson(ObjectSetup& os);
@@ -148,21 +201,57 @@ private:
 
     void DestroyObject(Object *object);
 
+    // Removes the object from objects and the per-type lists
+    void UnlistObject(Object *object);
+
+    // Replaces the terrain and uploads its texture, keeps the current terrain if the new one is null
+    void SwapTerrain(Terrain *newTerrain);
+
+    // Swaps in a finished background terrain and starts the next queued image, if any
+    void CollectRegeneratedTerrain();
+
     nlohmann::json GetGeneralInfo();
 
     std::vector<TornadoData> tornadoDatas;
     std::vector<VolcanoData> volcanoDatas;
     std::vector<AlienData> alienDatas;
 
+    EnvironmentField environmentField;
+
+    WorldState worldState;
+
+    SensorFrame sensorFrame;
+
+    UpdateScheduler scheduler;
+
     Robot *robot;
     Terrain *terrain{nullptr};
-    std::vector<Object *> objects;
+
+    std::future<Terrain *> regeneratedTerrain;
+    std::vector<unsigned char> queuedTerrainImage;
+    SlotMap<Object *> objects;
+    std::unordered_map<unsigned int, SlotHandle> objectIds;
+
+    // Per-type lists, kept up to date when objects are spawned and destroyed
+    SlotMap<Object *> updateableObjects;
+    SlotMap<Object *> drawableObjects;
+    std::vector<Tornado *> tornadoes;
+    std::vector<Alien *> aliens;
+    std::vector<ProximitySensor *> querySensors;
+    std::vector<PhysicalWeatherSensor *> weatherSensors;
 
     // Cleared every frame
     std::vector<Object*> objectsSpawned;
-    std::vector<Object*> objectsDestroyed;
+    std::vector<SlotHandle> objectsDestroyed;
+
+    // Reused every frame by ApplySlopeForce, terrain pixel positions and sampled gradients of the movable objects
+    std::vector<Object *> slopeObjects;
+    std::vector<float> slopeXs, slopeYs;
+    std::vector<float> slopeGradientXs, slopeGradientYs;
 
     float imageScaleFactorMultiplier;
+
+    std::chrono::system_clock::time_point startTimePoint;
 };
 
 #endif
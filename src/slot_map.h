@@ -0,0 +1,160 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_SLOT_MAP_H
+#define MARSIM_SLOT_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Refers to a slot map value. The generation changes when the value is erased, so old handles stop resolving.
+struct SlotHandle
+{
+    uint32_t index{UINT32_MAX};
+    uint32_t generation{0};
+
+    bool
+    operator==(const SlotHandle &other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool
+    operator!=(const SlotHandle &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Values are packed in a dense array for iteration. Insert, erase and lookup are O(1). Erasing moves the last value
+// into the hole, so iteration order is not kept.
+template <typename T>
+class SlotMap
+{
+public:
+    SlotHandle
+    insert(const T &value)
+    {
+        uint32_t index;
+        if (freeSlots.empty()) {
+            index = static_cast<uint32_t>(slots.size());
+            slots.push_back({});
+        } else {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+
+        auto &slot = slots[index];
+        slot.denseIndex = static_cast<uint32_t>(values.size());
+        values.push_back(value);
+        denseToSlot.push_back(index);
+
+        return {index, slot.generation};
+    }
+
+    // Returns false if the handle is stale
+    bool
+    erase(SlotHandle handle)
+    {
+        if (!contains(handle)) {
+            return false;
+        }
+
+        auto &slot = slots[handle.index];
+        uint32_t last = static_cast<uint32_t>(values.size()) - 1;
+        if (slot.denseIndex != last) {
+            values[slot.denseIndex] = std::move(values[last]);
+            denseToSlot[slot.denseIndex] = denseToSlot[last];
+            slots[denseToSlot[last]].denseIndex = slot.denseIndex;
+        }
+        values.pop_back();
+        denseToSlot.pop_back();
+
+        slot.generation++;
+        freeSlots.push_back(handle.index);
+        return true;
+    }
+
+    bool
+    contains(SlotHandle handle) const
+    {
+        // Erasing bumps the generation of the slot, so a free slot never matches a handle that was handed out
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+    }
+
+    // Null if the handle is stale
+    T *
+    get(SlotHandle handle)
+    {
+        return contains(handle) ? &values[slots[handle.index].denseIndex] : nullptr;
+    }
+
+    size_t
+    size() const
+    {
+        return values.size();
+    }
+
+    bool
+    empty() const
+    {
+        return values.empty();
+    }
+
+    void
+    clear()
+    {
+        for (auto index : denseToSlot) {
+            slots[index].generation++;
+            freeSlots.push_back(index);
+        }
+        values.clear();
+        denseToSlot.clear();
+    }
+
+    typename std::vector<T>::iterator
+    begin()
+    {
+        return values.begin();
+    }
+
+    typename std::vector<T>::iterator
+    end()
+    {
+        return values.end();
+    }
+
+private:
+    struct Slot
+    {
+        uint32_t denseIndex{UINT32_MAX};
+        uint32_t generation{0};
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<T> values;
+    std::vector<uint32_t> denseToSlot;
+};
+
+#endif // MARSIM_SLOT_MAP_H
@@ -0,0 +1,84 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_SPSC_QUEUE_H
+#define MARSIM_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for one producer thread and one consumer thread. Values are moved in and out of a ring of
+// preallocated slots, so neither side ever waits for the other.
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity) : slots(capacity + 1) {}
+
+    // Producer only. Returns false and leaves the value alone if the queue is full.
+    bool
+    push(T &&value)
+    {
+        const size_t tail = this->tail.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) % slots.size();
+        if (next == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        slots[tail] = std::move(value);
+        this->tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false if the queue is empty.
+    bool
+    pop(T &value)
+    {
+        const size_t head = this->head.load(std::memory_order_relaxed);
+        if (head == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        value = std::move(slots[head]);
+        this->head.store((head + 1) % slots.size(), std::memory_order_release);
+        return true;
+    }
+
+    // On the producer side an upper bound, the consumer may have taken more since
+    size_t
+    size() const
+    {
+        const size_t head = this->head.load(std::memory_order_acquire);
+        const size_t tail = this->tail.load(std::memory_order_acquire);
+        return (tail + slots.size() - head) % slots.size();
+    }
+
+private:
+    std::vector<T> slots;
+
+    // On separate cache lines, each is written by one side only
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+#endif // MARSIM_SPSC_QUEUE_H
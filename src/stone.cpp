@@ -42,12 +42,14 @@ Stone::Stone(Simulation* simulation, b2Vec2 pos, float radius) : Object(simulati
     fixdef.friction = 0.5;
     fixdef.restitution = 0.4;
     fixdef.userData.pointer = reinterpret_cast<uintptr_t>(this);
+    fixdef.filter.categoryBits = CollisionCategory::Stone;
     b2CircleShape shape;
     shape.m_radius = radius;
     fixdef.shape = &shape;
     body->CreateFixture(&fixdef);
 
     name = "Stone";
+    type = ObjectType::Stone;
 }
 
 void
@@ -22,71 +22,48 @@
 
 #include "temperature_sensor.h"
 #include "framework/draw.h"
-#include "glm/common.hpp"
 #include "json.hpp"
 #include "mqtt.h"
 #include "simulation.h"
-#include "volcano.h"
 
 TemperatureSensor::TemperatureSensor(Simulation *simulation, b2Vec2 pos) : PhysicalWeatherSensor(simulation, pos)
 {
     name = "Temperature Sensor";
+    type = ObjectType::TemperatureSensor;
 }
 
-void
-TemperatureSensor::update()
+float
+TemperatureSensor::getTemperature()
 {
-    g_debugDraw.DrawCircle(getPosition(), 1.f, b2Color{1.f, 0.f, 0.f, 1.f});
-
-    auto &&tornadoes = simulation->GetTornados();
-    auto &&volcanoes = simulation->GetVolcanoes();
-    auto &&aliens = simulation->GetAliens();
-
-    float temperature = 25.f;
-    constexpr float tornadoTemperature = 5.f;
-    constexpr float alienTemperature = 75.f;
-    float volcanoTemperature = 100.f;
-
-    if (simulation->volcano && simulation->volcano->isActive()) {
-        volcanoTemperature = 850.f;
-    }
+    return simulation->GetEnvironmentField().sample(getPosition()).temperature;
+}
 
-    for (auto &&tornado : tornadoes) {
-        b2Vec2 strength{tornado.pos - getPosition()};
-        float attenuation = strength.LengthSquared();
-        attenuation /= 1.f;
-        attenuation = glm::clamp(attenuation, 0.f, 100000.f);
-        temperature = glm::mix(tornadoTemperature, temperature, attenuation / 100000.f);
+void
+TemperatureSensor::publish()
+{
+    auto writer = Mqtt::getInstance().beginMessage("out/sensors", name, object_id);
+    if (!writer) {
+        return;
     }
 
-    for (auto &&alien : aliens) {
-        b2Vec2 strength{alien.pos - getPosition()};
-        float attenuation = 100.f * strength.LengthSquared();
-        attenuation /= 1.f;
-        attenuation = glm::clamp(attenuation, 0.f, 100000.f);
-        temperature = glm::mix(alienTemperature, temperature, attenuation / 100000.f);
-    }
+    auto pos = getPosition();
+    writer->beginObject(3);
+    writer->key("id");
+    writer->value(object_id);
+    writer->key("pos");
+    writer->position(pos.x, pos.y);
+    writer->key("temp");
+    writer->value(getTemperature());
+    writer->endObject();
+
+    Mqtt::getInstance().endMessage();
+}
 
-    for (auto &&volcano : volcanoes) {
-        b2Vec2 strength{volcano.pos - getPosition()};
-        float attenuation = strength.LengthSquared();
-        attenuation /= 1.f;
-        attenuation = glm::clamp(attenuation, 0.f, 100000.f);
-        temperature = glm::mix(volcanoTemperature, temperature, attenuation / 100000.f);
-    }
+void
+TemperatureSensor::draw()
+{
+    g_debugDraw.DrawCircle(getPosition(), 1.f, b2Color{1.f, 0.f, 0.f, 1.f});
 
-    std::string str = std::to_string(temperature) + "'C";
+    std::string str = std::to_string(getTemperature()) + "'C";
     g_debugDraw.DrawString(getPosition(), str.c_str());
-
-    if (simulation->GetStepCount() % updateFrequency == 0) {
-        nlohmann::json j;
-
-        auto pos = getPosition();
-        j["pos"] = {{"x", pos.x}, {"y", pos.y}};
-
-        j["temp"] = temperature;
-        j["id"] = object_id;
-
-        Mqtt::getInstance().send("out/sensors", name, j);
-    }
 }
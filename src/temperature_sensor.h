@@ -30,7 +30,11 @@ class TemperatureSensor : public PhysicalWeatherSensor
 public:
     TemperatureSensor(Simulation *simulation, b2Vec2 pos);
 
-    void update() override;
+    void publish() override;
+
+    void draw() override;
+
+    float getTemperature();
 };
 
 #endif // MARSIM_TEMPERATURE_SENSOR_H
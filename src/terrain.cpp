@@ -21,36 +21,114 @@
 // SOFTWARE.
 
 #include "terrain.h"
-#include "blur.h"
-#include "glad/gl.h"
+#include "gaussian_blur.h"
+#include "framework/draw.h"
 
 #include <stb_image.h>
 #include <stb_image_write.h>
 #include <stb_image_resize.h>
 
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
 
-Terrain::Terrain(const std::string &gaussianImagePath)
-{
-
-    stbi_set_flip_vertically_on_load(false);
+#if defined(__SSE2__) || defined(_M_X64)
+#define MARSIM_TERRAIN_SSE2
+#include <emmintrin.h>
+#endif
 
-    unsigned char *image_data{nullptr};
+Terrain::Terrain(const std::string &imagePath)
+{
     int channels = 0;
-    image_data = stbi_load(gaussianImagePath.c_str(), &width, &height, &channels, 1);
+    unsigned char *image_data = stbi_load(imagePath.c_str(), &width, &height, &channels, 0);
 
     if (image_data == nullptr) {
-        std::cerr << "Failed loading image!" << std::endl;
+        std::cerr << "Failed loading image: " << imagePath << "!" << std::endl;
         return;
     }
 
-    map.resize(width * height);
+    std::vector<unsigned char> pixels(image_data, image_data + width * height * channels);
+    stbi_image_free(image_data);
+
+    generateFromPixels(std::move(pixels), channels);
+    uploadTexture();
+}
+
+Terrain::Terrain(std::vector<unsigned char> pixels, int width, int height, int channels)
+{
+    this->width = width;
+    this->height = height;
+
+    generateFromPixels(std::move(pixels), channels);
+}
 
-    std::copy(image_data, image_data + width * height, map.data());
+Terrain *
+Terrain::CreateFromHardEdgeImage(const std::vector<unsigned char> &encodedImage,
+                                 float sigma,
+                                 const std::string &gaussianImageOutputPath)
+{
+    int width, height, channels;
+    unsigned char *image_data = stbi_load_from_memory(
+        encodedImage.data(), (int)encodedImage.size(), &width, &height, &channels, 0);
+
+    if (image_data == nullptr) {
+        std::cerr << "Failed decoding image: " << stbi_failure_reason() << std::endl;
+        return nullptr;
+    }
 
+    int resizeWidth = float(width) * terrainScaling;
+    int resizedHeight = float(height) * terrainScaling;
+    std::vector<unsigned char> resized_image(resizeWidth * resizedHeight * channels);
+    stbir_resize_uint8(
+        image_data, width, height, 0, resized_image.data(), resizeWidth, resizedHeight, 0, channels);
+
+    // Free original image, continue work on resized_image
     stbi_image_free(image_data);
 
-    generateTexture(gaussianImagePath);
+    // Blur the color channels and add the original occlusion map on top of the blurred map
+    GaussianBlur::blurImage(resized_image.data(), resizeWidth, resizedHeight, channels, sigma, true);
+
+    if (!gaussianImageOutputPath.empty()) {
+        // The image can be read for a request while this runs in the background, so it is replaced in one rename
+        // instead of being rewritten in place. The temporary file keeps the extension that picks the format.
+        std::filesystem::path tempPath = gaussianImageOutputPath;
+        tempPath.replace_extension(".tmp" + tempPath.extension().string());
+        saveImage(tempPath.string(), resized_image.data(), resizeWidth, resizedHeight, channels);
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, gaussianImageOutputPath, error);
+        if (error) {
+            std::cerr << "Could not replace " << gaussianImageOutputPath << ": " << error.message() << std::endl;
+        }
+    }
+
+    return new Terrain{std::move(resized_image), resizeWidth, resizedHeight, channels};
+}
+
+void
+Terrain::generateFromPixels(std::vector<unsigned char> pixels, int channels)
+{
+    // Heights are the luminance of the image, computed the same way as stb_image converts to one channel
+    map.resize(width * height);
+    for (int i = 0; i < width * height; i++) {
+        const unsigned char *pixel = &pixels[i * channels];
+        if (channels >= 3) {
+            map[i] = (unsigned char)((pixel[0] * 77 + pixel[1] * 150 + pixel[2] * 29) >> 8);
+        } else {
+            map[i] = pixel[0];
+        }
+    }
+
+    generateGradientField();
+
+    // The texture is drawn bottom up, so its rows are flipped
+    const int rowSize = width * channels;
+    texturePixels.resize(pixels.size());
+    for (int y = 0; y < height; y++) {
+        std::copy(&pixels[(height - 1 - y) * rowSize], &pixels[(height - y) * rowSize], &texturePixels[y * rowSize]);
+    }
+    textureChannels = channels;
 }
 
 unsigned char
@@ -68,42 +146,141 @@ Terrain::getHeight(int x, int y)
 }
 
 void
-Terrain::generateTexture(const std::string &gaussianImagePath)
+Terrain::generateGradientField()
+{
+    gradientFieldWidth = width + 3;
+    gradientField.assign(2 * gradientFieldWidth * (height + 3), 0.f);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            // Central differences, one-sided and doubled at the edges of the map
+            float slopeX = getHeight(x < width - 1 ? x + 1 : x, y) - getHeight(x > 0 ? x - 1 : x, y);
+            float slopeY = getHeight(x, y < height - 1 ? y + 1 : y) - getHeight(x, y > 0 ? y - 1 : y);
+
+            if (x == 0 || x == width - 1) {
+                slopeX *= 2;
+            }
+
+            if (y == 0 || y == height - 1) {
+                slopeY *= 2;
+            }
+
+            const int index = 2 * ((y + 1) * gradientFieldWidth + x + 1);
+            gradientField[index] = slopeX;
+            gradientField[index + 1] = slopeY;
+        }
+    }
+}
+
+void
+Terrain::sampleGradient(float x, float y, float &gradientX, float &gradientY)
 {
+    if (gradientField.empty()) {
+        gradientX = 0.f;
+        gradientY = 0.f;
+        return;
+    }
+
+    // Clamping into the zero border makes every position outside the map sample zero
+    x = std::clamp(x, -1.f, (float)width) + 1.f;
+    y = std::clamp(y, -1.f, (float)height) + 1.f;
 
-    glGenTextures(1, &terrainTextureID);
-    int nrChannels;
-
-    stbi_set_flip_vertically_on_load(true);
-
-    unsigned char *data = stbi_load(gaussianImagePath.c_str(), &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format;
-        if (nrChannels == 1) {
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-            format = GL_RED;
-        } else if (nrChannels == 3) {
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-            format = GL_RGB;
-        } else if (nrChannels == 4) {
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-            format = GL_RGBA;
+    const int x0 = (int)x;
+    const int y0 = (int)y;
+    const float fx = x - (float)x0;
+    const float fy = y - (float)y0;
+
+    const float *row0 = &gradientField[2 * (y0 * gradientFieldWidth + x0)];
+    const float *row1 = row0 + 2 * gradientFieldWidth;
+
+    const float w00 = (1.f - fx) * (1.f - fy);
+    const float w10 = fx * (1.f - fy);
+    const float w01 = (1.f - fx) * fy;
+    const float w11 = fx * fy;
+
+    gradientX = w00 * row0[0] + w10 * row0[2] + w01 * row1[0] + w11 * row1[2];
+    gradientY = w00 * row0[1] + w10 * row0[3] + w01 * row1[1] + w11 * row1[3];
+}
+
+void
+Terrain::sampleGradients(const float *xs, const float *ys, float *gradientXs, float *gradientYs, int count)
+{
+    int i = 0;
+
+#ifdef MARSIM_TERRAIN_SSE2
+    if (!gradientField.empty()) {
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 minimum = _mm_set1_ps(-1.f);
+        const __m128 maxX = _mm_set1_ps((float)width);
+        const __m128 maxY = _mm_set1_ps((float)height);
+
+        for (; i + 4 <= count; i += 4) {
+            // Positions are clamped into the border so truncation equals floor
+            __m128 x = _mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(xs + i), minimum), maxX), one);
+            __m128 y = _mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(ys + i), minimum), maxY), one);
+
+            __m128i x0 = _mm_cvttps_epi32(x);
+            __m128i y0 = _mm_cvttps_epi32(y);
+            __m128 fx = _mm_sub_ps(x, _mm_cvtepi32_ps(x0));
+            __m128 fy = _mm_sub_ps(y, _mm_cvtepi32_ps(y0));
+
+            alignas(16) int cx[4], cy[4];
+            _mm_store_si128((__m128i *)cx, x0);
+            _mm_store_si128((__m128i *)cy, y0);
+
+            // SSE2 has no gather, the four taps of each lane are loaded one lane at a time
+            alignas(16) float taps[8][4];
+            for (int lane = 0; lane < 4; lane++) {
+                const float *row0 = &gradientField[2 * (cy[lane] * gradientFieldWidth + cx[lane])];
+                const float *row1 = row0 + 2 * gradientFieldWidth;
+                for (int tap = 0; tap < 4; tap++) {
+                    taps[tap][lane] = row0[tap];
+                    taps[tap + 4][lane] = row1[tap];
+                }
+            }
+
+            const __m128 rx = _mm_sub_ps(one, fx);
+            const __m128 ry = _mm_sub_ps(one, fy);
+            const __m128 w00 = _mm_mul_ps(rx, ry);
+            const __m128 w10 = _mm_mul_ps(fx, ry);
+            const __m128 w01 = _mm_mul_ps(rx, fy);
+            const __m128 w11 = _mm_mul_ps(fx, fy);
+
+            // Even taps hold x gradients, odd taps y gradients, taps 4 to 7 are from the next row
+            __m128 gx = _mm_mul_ps(w00, _mm_load_ps(taps[0]));
+            gx = _mm_add_ps(gx, _mm_mul_ps(w10, _mm_load_ps(taps[2])));
+            gx = _mm_add_ps(gx, _mm_mul_ps(w01, _mm_load_ps(taps[4])));
+            gx = _mm_add_ps(gx, _mm_mul_ps(w11, _mm_load_ps(taps[6])));
+
+            __m128 gy = _mm_mul_ps(w00, _mm_load_ps(taps[1]));
+            gy = _mm_add_ps(gy, _mm_mul_ps(w10, _mm_load_ps(taps[3])));
+            gy = _mm_add_ps(gy, _mm_mul_ps(w01, _mm_load_ps(taps[5])));
+            gy = _mm_add_ps(gy, _mm_mul_ps(w11, _mm_load_ps(taps[7])));
+
+            _mm_storeu_ps(gradientXs + i, gx);
+            _mm_storeu_ps(gradientYs + i, gy);
         }
+    }
+#endif
 
-        glBindTexture(GL_TEXTURE_2D, terrainTextureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+    for (; i < count; i++) {
+        sampleGradient(xs[i], ys[i], gradientXs[i], gradientYs[i]);
+    }
+}
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    } else {
-        std::cerr << "Texture failed to load at path: " << gaussianImagePath << std::endl;
+void
+Terrain::uploadTexture()
+{
+    if (texturePixels.empty()) {
+        return;
     }
 
-    stbi_image_free(data);
+    terrainTextureID = g_debugDraw.CreateImageTexture(texturePixels.data(), width, height, textureChannels);
+
+    texturePixels.clear();
+    texturePixels.shrink_to_fit();
 }
+
 unsigned int
 Terrain::getTextureID()
 {
@@ -111,9 +288,7 @@ Terrain::getTextureID()
 }
 Terrain::~Terrain()
 {
-    if (terrainTextureID) {
-        glDeleteTextures(1, &terrainTextureID);
-    }
+    g_debugDraw.DestroyImageTexture(terrainTextureID);
 }
 int
 Terrain::getTextureHeight()
@@ -127,111 +302,19 @@ Terrain::getTextureWidth()
 }
 
 void
-Terrain::GenerateGaussianImageFromHardEdgeImage(const std::string &hardImagePath,
-                                                const std::string &gaussianImageOutputPath,
-                                                float sigma)
+Terrain::saveImage(const std::string &path, const unsigned char *pixels, int width, int height, int channels)
 {
-
-    stbi_set_flip_vertically_on_load(false);
-
-    int width, height;
-
-    unsigned char *image_data{nullptr};
-    int channels = 0;
-    image_data = stbi_load(hardImagePath.c_str(), &width, &height, &channels, 0);
-
-    if (image_data == nullptr) {
-        std::cerr << "Failed loading image: " << hardImagePath << "!" << std::endl;
-        return;
-    }
-
-    if (channels < 3) {
-        std::cerr << "Input images must be RGB images." << std::endl;
-    }
-
-    int resizeWidth = float(width) * terrainScaling;
-    int resizedHeight = float(height) * terrainScaling;
-    unsigned char* resized_image = (unsigned char*)malloc(resizeWidth * resizedHeight * channels);
-    stbir_resize_uint8(image_data, width, height, 0, resized_image, resizeWidth, resizedHeight, 0, channels);
-
-    // Free original image, continue work on resized_image
-    stbi_image_free(image_data);
-
-    // copy data
-    int size = resizeWidth * resizedHeight;
-
-    // output channels r,g,b
-    float *newb = new float[size];
-    float *newg = new float[size];
-    float *newr = new float[size];
-
-    // input channels r,g,b
-    float *oldb = new float[size];
-    float *oldg = new float[size];
-    float *oldr = new float[size];
-
-    // channels copy r,g,b
-    for (int i = 0; i < size; ++i) {
-        oldb[i] = resized_image[channels * i + 0] / 255.f;
-        oldg[i] = resized_image[channels * i + 1] / 255.f;
-        oldr[i] = resized_image[channels * i + 2] / 255.f;
-    }
-
-    // input channels r,g,b
-    float *origb = new float[size];
-    float *origg = new float[size];
-    float *origr = new float[size];
-
-    // channels copy r,g,b
-    for (int i = 0; i < size; ++i) {
-        origb[i] = resized_image[channels * i + 0] / 255.f;
-        origg[i] = resized_image[channels * i + 1] / 255.f;
-        origr[i] = resized_image[channels * i + 2] / 255.f;
-    }
-
-    Blur::fast_gaussian_blur(oldb, newb, resizeWidth, resizedHeight, sigma);
-    Blur::fast_gaussian_blur(oldg, newg, resizeWidth, resizedHeight, sigma);
-    Blur::fast_gaussian_blur(oldr, newr, resizeWidth, resizedHeight, sigma);
-
-    // channels copy r,g,b
-    for (int i = 0; i < size; ++i) {
-        resized_image[channels * i + 0] = (unsigned char)std::min(255.f, std::max(0.f, 255.f * newb[i]));
-        resized_image[channels * i + 1] = (unsigned char)std::min(255.f, std::max(0.f, 255.f * newg[i]));
-        resized_image[channels * i + 2] = (unsigned char)std::min(255.f, std::max(0.f, 255.f * newr[i]));
-
-        // Add original occlusion map on top of blurred map
-        resized_image[channels * i + 0] =
-            (unsigned char)std::min(255.f, std::max(0.f, resized_image[channels * i + 0] + 255.f * origb[i]));
-        resized_image[channels * i + 1] =
-            (unsigned char)std::min(255.f, std::max(0.f, resized_image[channels * i + 1] + 255.f * origg[i]));
-        resized_image[channels * i + 2] =
-            (unsigned char)std::min(255.f, std::max(0.f, resized_image[channels * i + 2] + 255.f * origr[i]));
-    }
-
-    // save
-    std::string file(gaussianImageOutputPath);
+    std::string file(path);
     std::string ext = file.substr(file.size() - 3);
     if (ext == "bmp")
-        stbi_write_bmp(gaussianImageOutputPath.c_str(), resizeWidth, resizedHeight, channels, resized_image);
+        stbi_write_bmp(path.c_str(), width, height, channels, pixels);
     else if (ext == "jpg")
-        stbi_write_jpg(gaussianImageOutputPath.c_str(), resizeWidth, resizedHeight, channels, resized_image, 90);
+        stbi_write_jpg(path.c_str(), width, height, channels, pixels, 90);
     else {
         if (ext != "png") {
             std::cerr << "format '" << ext << "' not supported writing default .png" << std::endl;
             file = file.substr(0, file.size() - 4) + std::string(".png");
         }
-        stbi_write_png(file.c_str(), resizeWidth, resizedHeight, channels, resized_image, channels * resizeWidth);
+        stbi_write_png(file.c_str(), width, height, channels, pixels, channels * width);
     }
-    stbi_image_free(resized_image);
-
-    // clean memory
-    delete[] newr;
-    delete[] newb;
-    delete[] newg;
-    delete[] oldr;
-    delete[] oldb;
-    delete[] oldg;
-    delete[] origb;
-    delete[] origg;
-    delete[] origr;
 }
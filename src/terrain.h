@@ -30,30 +30,60 @@ class Terrain
 {
 
 public:
-    explicit Terrain(const std::string &gaussianImagePath);
+    // Loads the terrain from an image file and uploads its texture right away
+    explicit Terrain(const std::string &imagePath);
+
+    // Builds the terrain from decoded pixels, the texture is uploaded later by uploadTexture
+    Terrain(std::vector<unsigned char> pixels, int width, int height, int channels);
 
     ~Terrain();
 
     unsigned char getHeight(int x, int y);
 
+    // Bilinearly interpolated height gradient at a pixel position, zero outside the map.
+    // gradientX is the height difference towards +x, gradientY towards +y, both across two pixels.
+    void sampleGradient(float x, float y, float &gradientX, float &gradientY);
+
+    // Samples count positions at once, the same as calling sampleGradient for each of them
+    void sampleGradients(const float *xs, const float *ys, float *gradientXs, float *gradientYs, int count);
+
+    // Uploads the texture from the kept pixels and frees them, must be called on the thread owning the GL context
+    void uploadTexture();
+
     unsigned int getTextureID();
 
     int getTextureWidth();
 
     int getTextureHeight();
 
-    static void GenerateGaussianImageFromHardEdgeImage(const std::string &hardImagePath,
-                                                       const std::string &gaussianImageOutputPath,
-                                                       float sigma);
+    // Decodes an image from memory, then resizes and blurs it into a terrain. Does not touch GL, so it can run on a
+    // background thread. The blurred image is also saved to gaussianImageOutputPath unless it is empty.
+    // Returns nullptr if the image can not be decoded.
+    static Terrain *CreateFromHardEdgeImage(const std::vector<unsigned char> &encodedImage,
+                                            float sigma,
+                                            const std::string &gaussianImageOutputPath);
+
+    static void saveImage(const std::string &path, const unsigned char *pixels, int width, int height, int channels);
 
     static inline float terrainScaling{1.f};
 
 private:
     unsigned int terrainTextureID{};
-    void generateTexture(const std::string &gaussianImagePath);
+    void generateFromPixels(std::vector<unsigned char> pixels, int channels);
+
+    void generateGradientField();
 
     int width{}, height{};
     std::vector<unsigned char> map{};
+
+    // Flipped copy of the image, kept until uploadTexture
+    std::vector<unsigned char> texturePixels{};
+    int textureChannels{};
+
+    // Interleaved x and y gradients with a zero border, one pixel before and two after the map on each axis,
+    // so the four bilinear taps never need bounds checks
+    std::vector<float> gradientField{};
+    int gradientFieldWidth{};
 };
 
 #endif // MARSIM_TERRAIN_H
@@ -0,0 +1,132 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+    for (unsigned int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+
+    for (auto &&worker : workers) {
+        worker.join();
+    }
+}
+
+void
+ThreadPool::parallelFor(int count, int grainSize, const std::function<void(int, int)> &func)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    const int maxChunks = (int)workers.size() + 1;
+    const int chunks = std::clamp(count / std::max(grainSize, 1), 1, maxChunks);
+
+    if (chunks == 1) {
+        func(0, count);
+        return;
+    }
+
+    const int chunkSize = (count + chunks - 1) / chunks;
+    int remaining = chunks - 1;
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        for (int c = 1; c < chunks; c++) {
+            const int begin = c * chunkSize;
+            const int end = std::min(count, begin + chunkSize);
+            auto run = [this, &func, &remaining, begin, end]() {
+                if (begin < end) {
+                    func(begin, end);
+                }
+                std::lock_guard<std::mutex> lock{mutex};
+                remaining--;
+                jobFinished.notify_all();
+            };
+            jobs.push_back({&remaining, std::move(run)});
+        }
+    }
+    jobAvailable.notify_all();
+
+    func(0, std::min(count, chunkSize));
+
+    // Take back our own chunks that no worker has started yet, then wait for the rest
+    std::unique_lock<std::mutex> lock{mutex};
+    while (remaining > 0) {
+        if (!runQueuedJob(lock, &remaining)) {
+            jobFinished.wait(lock);
+        }
+    }
+}
+
+unsigned int
+ThreadPool::getThreadCount()
+{
+    return (unsigned int)workers.size();
+}
+
+void
+ThreadPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    while (true) {
+        jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+        if (stopping && jobs.empty()) {
+            return;
+        }
+
+        runQueuedJob(lock);
+    }
+}
+
+bool
+ThreadPool::runQueuedJob(std::unique_lock<std::mutex> &lock, const void *batch)
+{
+    auto it = batch ? std::find_if(jobs.begin(), jobs.end(), [batch](const Job &job) { return job.batch == batch; })
+                    : jobs.begin();
+    if (it == jobs.end()) {
+        return false;
+    }
+
+    auto job = std::move(it->run);
+    jobs.erase(it);
+
+    lock.unlock();
+    job();
+    lock.lock();
+
+    return true;
+}
@@ -0,0 +1,78 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_THREAD_POOL_H
+#define MARSIM_THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for splitting read-only work, such as batched ray casts, into chunks.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int threadCount);
+
+    ~ThreadPool();
+
+    // Calls func(begin, end) over [0, count) in chunks of at least grainSize items and returns when all are done.
+    // The calling thread works on chunks of this call too, so it is safe to call from inside a worker. It never runs
+    // chunks of other calls, so a short call is not held up by a long one that was queued before it.
+    void parallelFor(int count, int grainSize, const std::function<void(int begin, int end)> &func);
+
+    unsigned int getThreadCount();
+
+    static ThreadPool &
+    getInstance()
+    {
+        static ThreadPool instance{std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1
+                                                                          : 0};
+        return instance;
+    }
+
+private:
+    void workerLoop();
+
+    struct Job
+    {
+        const void *batch; // the parallelFor call the job is a chunk of
+        std::function<void()> run;
+    };
+
+    // Runs the first queued job, or the first one of the batch if it is set. Expects the lock to be held.
+    bool runQueuedJob(std::unique_lock<std::mutex> &lock, const void *batch = nullptr);
+
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobFinished;
+
+    bool stopping{false};
+};
+
+#endif // MARSIM_THREAD_POOL_H
@@ -29,6 +29,7 @@ Tornado::Tornado(Simulation *simulation, b2Vec2 pos, float radius, float magnitu
 {
     this->radius = radius;
     this->magnitude = magnitude;
+    type = ObjectType::Tornado;
 
     FindNewMoveToTarget();
 }
@@ -0,0 +1,191 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "update_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Tolerance for simulated time accumulated in floating point, a job due this close to now is run now
+constexpr double dueTolerance = 1e-6;
+} // namespace
+
+UpdateScheduler::UpdateScheduler(double slotDuration)
+    : slotDuration{slotDuration}, wheel(wheelSize), load(wheelSize, 0)
+{
+}
+
+void
+UpdateScheduler::setSlotDuration(double duration)
+{
+    if (duration <= 0.0 || duration == slotDuration) {
+        return;
+    }
+
+    // Every job is in exactly one slot of the wheel, next to handles of removed jobs
+    dueJobs.clear();
+    for (auto &&handles : wheel) {
+        for (auto &&handle : handles) {
+            if (entries.contains(handle)) {
+                dueJobs.push_back(handle);
+            }
+        }
+        handles.clear();
+    }
+    std::fill(load.begin(), load.end(), 0);
+
+    currentSlot = (uint64_t)std::floor((double)currentSlot * slotDuration / duration + dueTolerance);
+    slotDuration = duration;
+
+    for (auto &&handle : dueJobs) {
+        auto entry = entries.get(handle);
+        entry->firstSlot = std::max(slotAt(entry->due), currentSlot + 1);
+        entry->periodSlots = std::max<uint64_t>(1, (uint64_t)std::llround(entry->period / slotDuration));
+        addLoad(entry->firstSlot, entry->periodSlots, 1);
+        insert(handle, entry->due);
+    }
+}
+
+SlotHandle
+UpdateScheduler::add(double period, Job job)
+{
+    const uint64_t periodSlots = std::max<uint64_t>(1, (uint64_t)std::llround(period / slotDuration));
+    const uint64_t candidates = std::min(periodSlots, wheelSize);
+
+    // Pick the phase where the jobs already scheduled are lightest over a turn of the wheel
+    uint64_t bestPhase = 0;
+    long bestLoad = -1;
+    for (uint64_t phase = 0; phase < candidates; phase++) {
+        long phaseLoad = 0;
+        for (uint64_t slot = phase; slot < wheelSize; slot += periodSlots) {
+            phaseLoad += load[(currentSlot + 1 + slot) % wheelSize];
+        }
+        if (bestLoad < 0 || phaseLoad < bestLoad) {
+            bestLoad = phaseLoad;
+            bestPhase = phase;
+        }
+    }
+
+    const uint64_t firstSlot = currentSlot + 1 + bestPhase;
+    addLoad(firstSlot, periodSlots, 1);
+
+    const double due = (double)firstSlot * slotDuration;
+    auto handle = entries.insert({std::move(job), period, due, firstSlot, periodSlots});
+    insert(handle, due);
+    return handle;
+}
+
+bool
+UpdateScheduler::remove(SlotHandle handle)
+{
+    // The handle stays in its wheel slot and is dropped when the slot comes around
+    if (auto entry = entries.get(handle)) {
+        addLoad(entry->firstSlot, entry->periodSlots, -1);
+        return entries.erase(handle);
+    }
+
+    return false;
+}
+
+void
+UpdateScheduler::advance(double now)
+{
+    const uint64_t nowSlot = (uint64_t)std::floor(now / slotDuration + dueTolerance);
+
+    // Every slot is looked at once at most, jobs further away than a turn of the wheel stay in their slot
+    const uint64_t first = currentSlot + 1;
+    const uint64_t last = std::min(nowSlot, currentSlot + wheelSize);
+    currentSlot = std::max(currentSlot, nowSlot);
+
+    dueJobs.clear();
+    for (uint64_t slot = first; slot <= last; slot++) {
+        auto &handles = wheel[slot % wheelSize];
+        auto kept = handles.begin();
+        for (auto &&handle : handles) {
+            auto entry = entries.get(handle);
+            if (!entry) {
+                continue;
+            }
+            if (entry->due <= now + dueTolerance) {
+                dueJobs.push_back(handle);
+            } else {
+                *kept++ = handle;
+            }
+        }
+        handles.erase(kept, handles.end());
+    }
+
+    for (auto &&handle : dueJobs) {
+        auto entry = entries.get(handle);
+        if (!entry) {
+            continue;
+        }
+
+        // Skips runs that were missed in a long step, keeping the phase
+        const double period = std::max(entry->period, slotDuration);
+        double periods = std::floor((now + dueTolerance - entry->due) / period) + 1.0;
+        entry->due += periods * period;
+        insert(handle, entry->due);
+
+        // Copied, the job can add jobs and move the entries around
+        Job job = entry->job;
+        job();
+    }
+}
+
+size_t
+UpdateScheduler::size() const
+{
+    return entries.size();
+}
+
+void
+UpdateScheduler::clear()
+{
+    entries.clear();
+    for (auto &&handles : wheel) {
+        handles.clear();
+    }
+    std::fill(load.begin(), load.end(), 0);
+}
+
+uint64_t
+UpdateScheduler::slotAt(double time) const
+{
+    return (uint64_t)std::ceil(time / slotDuration - dueTolerance);
+}
+
+void
+UpdateScheduler::addLoad(uint64_t firstSlot, uint64_t periodSlots, int amount)
+{
+    for (uint64_t slot = 0; slot < wheelSize; slot += periodSlots) {
+        load[(firstSlot + slot) % wheelSize] += amount;
+    }
+}
+
+void
+UpdateScheduler::insert(SlotHandle handle, double due)
+{
+    // Never into a slot that has been looked at already
+    wheel[std::max(slotAt(due), currentSlot + 1) % wheelSize].push_back(handle);
+}
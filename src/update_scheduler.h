@@ -0,0 +1,97 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_UPDATE_SCHEDULER_H
+#define MARSIM_UPDATE_SCHEDULER_H
+
+#include "slot_map.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Runs periodic jobs on simulated time with a hashed time wheel, so each step only looks at the jobs that are due
+// around it instead of asking every object whether its interval has passed. Jobs are spread over the steps of their
+// period, so jobs with the same period do not all run on the same step.
+class UpdateScheduler
+{
+public:
+    using Job = std::function<void()>;
+
+    // Each slot of the wheel covers slotDuration seconds of simulated time, ideally one step
+    explicit UpdateScheduler(double slotDuration = 1.0 / 60.0);
+
+    // Puts every job on the wheel again with slots of the new duration, keeping when they are due. Does nothing if
+    // the duration is the same.
+    void setSlotDuration(double duration);
+
+    // Runs the job every period seconds, but at most once per slot, the first time within one period from now. The first run is put on the
+    // slot where the fewest other jobs are due over a turn of the wheel.
+    SlotHandle add(double period, Job job);
+
+    // Returns false if the handle is stale. Jobs can remove themselves and others while they run.
+    bool remove(SlotHandle handle);
+
+    // Runs the jobs that became due up to the simulated time now, in the order they became due
+    void advance(double now);
+
+    size_t size() const;
+
+    // Removes every job
+    void clear();
+
+private:
+    struct Entry
+    {
+        Job job;
+        double period; // as asked for, jobs run once per slot at most
+        double due;
+
+        // Slot of the first run and the period in slots, to take the job out of the load again
+        uint64_t firstSlot;
+        uint64_t periodSlots;
+    };
+
+    static constexpr uint64_t wheelSize = 512;
+
+    // First slot that starts at or after the time
+    uint64_t slotAt(double time) const;
+
+    // Adds amount to the load of every slot the job runs on during a turn of the wheel
+    void addLoad(uint64_t firstSlot, uint64_t periodSlots, int amount);
+
+    void insert(SlotHandle handle, double due);
+
+    double slotDuration;
+    uint64_t currentSlot{0};
+
+    SlotMap<Entry> entries;
+    std::vector<std::vector<SlotHandle>> wheel;
+
+    // Number of jobs running on each slot during a turn of the wheel
+    std::vector<int> load;
+
+    // Reused by advance
+    std::vector<SlotHandle> dueJobs;
+};
+
+#endif // MARSIM_UPDATE_SCHEDULER_H
@@ -32,6 +32,7 @@ Volcano::Volcano(Simulation *simulation, b2Vec2 pos, float radius)
     : ProximitySensor(simulation, pos, radius, false, true)
 {
     this->radius = radius;
+    type = ObjectType::Volcano;
 }
 
 void
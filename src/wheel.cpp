@@ -47,6 +47,9 @@ Wheel::Wheel(Simulation* simulation, Robot *robot, float x, float y, float width
         fixdef.userData.pointer = reinterpret_cast<uintptr_t>(this);
         fixdef.density = 100.f;
         fixdef.isSensor = true;
+        // The wheel sensor only has to be seen by proximity sensors, it does not detect anything itself
+        fixdef.filter.categoryBits = CollisionCategory::RobotPart;
+        fixdef.filter.maskBits = CollisionCategory::Sensor;
         b2PolygonShape shape;
         shape.SetAsBox(width / 2.f, height / 2.f);
         fixdef.shape = &shape;
@@ -64,6 +67,7 @@ Wheel::Wheel(Simulation* simulation, Robot *robot, float x, float y, float width
     }
 
     name = "Robot Wheel";
+    type = ObjectType::Wheel;
     updateable = false;
 
     // Movable false because robot is movable instead
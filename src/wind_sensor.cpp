@@ -29,65 +29,45 @@
 WindSensor::WindSensor(Simulation *simulation, b2Vec2 pos) : PhysicalWeatherSensor(simulation, pos)
 {
     name = "Wind Sensor";
+    type = ObjectType::WindSensor;
 }
 
-void
-WindSensor::update()
+b2Vec2
+WindSensor::getWind()
 {
-    g_debugDraw.DrawCircle(getPosition(), 1.f, b2Color{1.f, 1.f, 1.f, 1.f});
-
-    auto &&tornadoes = simulation->GetTornados();
-    auto &&aliens = simulation->GetAliens();
-    //auto &&volcanoes = simulation->GetVolcanoes();
-
-    std::vector<b2Vec2> tornadoStrengths;
-    for (auto &&tornado : tornadoes) {
-        b2Vec2 strength{tornado.pos - getPosition()};
-        float attenuation = 1.f / strength.LengthSquared();
-        strength.x *= tornado.magnitude;
-        strength.y *= tornado.magnitude;
-        strength.x *= attenuation;
-        strength.y *= attenuation;
-        tornadoStrengths.push_back(strength);
-    }
+    return simulation->GetEnvironmentField().sample(getPosition()).wind;
+}
 
-    for (auto &&alien : aliens) {
-        b2Vec2 strength{alien.pos - getPosition()};
-        float attenuation = 100.f / strength.LengthSquared();
-        strength.x *= attenuation;
-        strength.y *= attenuation;
-        tornadoStrengths.push_back(strength);
+void
+WindSensor::publish()
+{
+    auto writer = Mqtt::getInstance().beginMessage("out/sensors", name, object_id);
+    if (!writer) {
+        return;
     }
 
-    /*for (auto &&volcano : volcanoes) {
-        b2Vec2 strength{volcano.pos - getPosition()};
-        float attenuation = 1000.f / strength.LengthSquared();
-        strength.x *= attenuation;
-        strength.y *= attenuation;
-        tornadoStrengths.push_back(-strength);
-    }*/
+    auto pos = getPosition();
+    writer->beginObject(3);
+    writer->key("id");
+    writer->value(object_id);
+    writer->key("pos");
+    writer->position(pos.x, pos.y);
+    auto strength = getWind();
+    writer->key("wind_vec");
+    writer->position(strength.x, strength.y);
+    writer->endObject();
+
+    Mqtt::getInstance().endMessage();
+}
 
-    b2Vec2 strength{0.f, 0.f};
-    for (auto &&tornadoStrength : tornadoStrengths) {
-        strength.x += tornadoStrength.x;
-        strength.y += tornadoStrength.y;
-    }
+void
+WindSensor::draw()
+{
+    g_debugDraw.DrawCircle(getPosition(), 1.f, b2Color{1.f, 1.f, 1.f, 1.f});
 
+    auto strength = getWind();
     g_debugDraw.DrawSegment(getPosition(), getPosition() + strength, b2Color(0.8f, 0.8f, 0.8f));
 
     std::string str = "{" + std::to_string(strength.x) + ", " + std::to_string(strength.y) + "}";
     g_debugDraw.DrawString(getPosition(), str.c_str());
-
-    if (simulation->GetStepCount() % updateFrequency == 0) {
-        nlohmann::json j;
-
-        auto pos = getPosition();
-        j["pos"] = {{"x", pos.x}, {"y", pos.y}};
-
-        j["wind_vec"] = {{"x", strength.x}, {"y", strength.y}};
-
-        j["id"] = object_id;
-
-        Mqtt::getInstance().send("out/sensors", name, j);
-    }
 }
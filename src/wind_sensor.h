@@ -30,7 +30,11 @@ class WindSensor : public PhysicalWeatherSensor
 public:
     WindSensor(Simulation* simulation, b2Vec2 pos);
 
-    void update() override;
+    void publish() override;
+
+    void draw() override;
+
+    b2Vec2 getWind();
 };
 
 #endif // MARSIM_WIND_SENSOR_H
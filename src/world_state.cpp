@@ -0,0 +1,311 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "world_state.h"
+#include "mqtt.h"
+
+#include <algorithm>
+#include <cmath>
+
+void
+WorldState::configure(float cellSize, float radius, float minDistance, float minAngle, double keyframeInterval)
+{
+    this->cellSize = cellSize;
+    this->radius = radius;
+    this->minDistance = minDistance;
+    this->minAngle = minAngle * b2_pi / 180.f;
+    this->keyframeInterval = keyframeInterval;
+
+    // Objects added before are in cells of the old size
+    cells.clear();
+    for (auto &&entry : entries) {
+        entry.cell = getCell(entry.object->getPosition());
+        cells[entry.cell].push_back(entry.object->worldStateHandle);
+    }
+}
+
+void
+WorldState::add(Object *object)
+{
+    switch (object->type) {
+    case ObjectType::Stone:
+    case ObjectType::Alien:
+    case ObjectType::FrictionZone:
+    case ObjectType::Tornado:
+    case ObjectType::Volcano:
+    case ObjectType::WeatherSensor:
+    case ObjectType::WindSensor:
+    case ObjectType::SeismicSensor:
+    case ObjectType::TemperatureSensor:
+        break;
+    default:
+        return;
+    }
+
+    Entry entry;
+    entry.object = object;
+    entry.id = object->GetObjectId();
+    entry.type = static_cast<int>(object->type);
+    entry.cell = getCell(object->getPosition());
+    object->worldStateHandle = entries.insert(entry);
+    cells[entry.cell].push_back(object->worldStateHandle);
+
+    if (typeIds.emplace(object->name, entry.type).second) {
+        keyframeNeeded = true;
+    }
+}
+
+void
+WorldState::remove(Object *object)
+{
+    auto entry = entries.get(object->worldStateHandle);
+    if (!entry) {
+        return;
+    }
+
+    if (entry->sent) {
+        destroyedIds.push_back(entry->id);
+    }
+    removeFromCell(entry->cell, object->worldStateHandle);
+    entries.erase(object->worldStateHandle);
+    object->worldStateHandle = {};
+}
+
+void
+WorldState::markAwake(Object *object)
+{
+    auto entry = entries.get(object->worldStateHandle);
+    if (entry && !entry->awake) {
+        entry->awake = true;
+        awakeHandles.push_back(object->worldStateHandle);
+    }
+}
+
+void
+WorldState::publish(b2Vec2 center, double time)
+{
+    // Sleeping bodies have not moved, the rest change cells as they cross the edges
+    for (auto &&handle : awakeHandles) {
+        auto entry = entries.get(handle);
+        if (!entry) {
+            continue;
+        }
+        entry->awake = false;
+        auto cell = getCell(entry->object->getPosition());
+        if (cell != entry->cell) {
+            removeFromCell(entry->cell, handle);
+            cells[cell].push_back(handle);
+            entry->cell = cell;
+        }
+    }
+    awakeHandles.clear();
+
+    // Deltas need the message before them, which latest value topics replace
+    auto &mqtt = Mqtt::getInstance();
+    const bool keyframe = keyframeNeeded || lastKeyframeTime < 0.0 || time - lastKeyframeTime >= keyframeInterval ||
+                          mqtt.getTopicSetting("out/world").latestValue ||
+                          mqtt.getDiscardedCount("out/world") != discardedMessages;
+
+    spawned.clear();
+    moved.clear();
+    inRange.clear();
+    left.clear();
+    queries++;
+
+    const auto minCellX = static_cast<int32_t>(std::floor((center.x - radius) / cellSize));
+    const auto maxCellX = static_cast<int32_t>(std::floor((center.x + radius) / cellSize));
+    const auto minCellY = static_cast<int32_t>(std::floor((center.y - radius) / cellSize));
+    const auto maxCellY = static_cast<int32_t>(std::floor((center.y + radius) / cellSize));
+    for (auto cellX = minCellX; cellX <= maxCellX; cellX++) {
+        for (auto cellY = minCellY; cellY <= maxCellY; cellY++) {
+            auto cell = cells.find(getCellKey(cellX, cellY));
+            if (cell == cells.end()) {
+                continue;
+            }
+
+            for (auto &&handle : cell->second) {
+                auto &entry = *entries.get(handle);
+                auto position = entry.object->getPosition();
+                if ((position - center).LengthSquared() > radius * radius) {
+                    continue;
+                }
+
+                entry.lastSeen = queries;
+                inRange.push_back(handle);
+                auto angle = entry.object->body->GetAngle();
+                if (keyframe || !entry.sent) {
+                    spawned.push_back({handle, position, angle});
+                } else if ((position - entry.sentPosition).Length() >= minDistance ||
+                           std::abs(angle - entry.sentAngle) >= minAngle) {
+                    moved.push_back({handle, position, angle});
+                }
+            }
+        }
+    }
+
+    // Removed objects are in destroyedIds already
+    for (auto &&handle : sentHandles) {
+        auto entry = entries.get(handle);
+        if (entry && entry->sent && entry->lastSeen != queries) {
+            left.push_back(handle);
+        }
+    }
+
+    if (!keyframe && spawned.empty() && moved.empty() && left.empty() && destroyedIds.empty()) {
+        return;
+    }
+
+    // Taken before beginMessage, a switch of the message format there makes the next message a keyframe
+    discardedMessages = mqtt.getDiscardedCount("out/world");
+    auto writer = mqtt.beginMessage("out/world", "WorldState");
+    if (!writer) {
+        // Nobody got the changes, so whoever listens next needs everything
+        keyframeNeeded = true;
+        destroyedIds.clear();
+        return;
+    }
+
+    // A keyframe replaces everything the client had, so nothing needs to be destroyed
+    writer->beginObject(keyframe ? 6 : 5);
+    writer->key("destroyed");
+    if (keyframe) {
+        writer->beginArray(0);
+    } else {
+        writer->beginArray(destroyedIds.size() + left.size());
+        for (auto &&id : destroyedIds) {
+            writer->value(id);
+        }
+        for (auto &&handle : left) {
+            writer->value(entries.get(handle)->id);
+        }
+    }
+    writer->endArray();
+    writer->key("keyframe");
+    writer->value(keyframe);
+
+    auto writeColumns = [&](const std::vector<Change> &changes, bool withType) {
+        writer->beginObject(withType ? 5 : 4);
+        writer->key("id");
+        writer->beginArray(changes.size());
+        for (auto &&change : changes) {
+            writer->value(entries.get(change.handle)->id);
+        }
+        writer->endArray();
+        writer->key("r");
+        writer->beginArray(changes.size());
+        for (auto &&change : changes) {
+            writer->value(change.angle);
+        }
+        writer->endArray();
+        if (withType) {
+            writer->key("type");
+            writer->beginArray(changes.size());
+            for (auto &&change : changes) {
+                writer->value(entries.get(change.handle)->type);
+            }
+            writer->endArray();
+        }
+        writer->key("x");
+        writer->beginArray(changes.size());
+        for (auto &&change : changes) {
+            writer->value(change.position.x);
+        }
+        writer->endArray();
+        writer->key("y");
+        writer->beginArray(changes.size());
+        for (auto &&change : changes) {
+            writer->value(change.position.y);
+        }
+        writer->endArray();
+        writer->endObject();
+    };
+
+    writer->key("moved");
+    writeColumns(moved, false);
+    writer->key("sequence");
+    writer->value(sequence);
+    writer->key("spawned");
+    writeColumns(spawned, true);
+    if (keyframe) {
+        writer->key("types");
+        writer->beginObject(typeIds.size());
+        for (auto &&[name, type] : typeIds) {
+            writer->key(name);
+            writer->value(type);
+        }
+        writer->endObject();
+    }
+    writer->endObject();
+
+    mqtt.endMessage();
+
+    // Everything in range has been sent now
+    std::swap(sentHandles, inRange);
+    for (auto &&handle : left) {
+        entries.get(handle)->sent = false;
+    }
+    for (auto &&changes : {&spawned, &moved}) {
+        for (auto &&change : *changes) {
+            auto &entry = *entries.get(change.handle);
+            entry.sent = true;
+            entry.sentPosition = change.position;
+            entry.sentAngle = change.angle;
+        }
+    }
+    destroyedIds.clear();
+    sequence++;
+    if (keyframe) {
+        lastKeyframeTime = time;
+        keyframeNeeded = false;
+    }
+}
+
+uint64_t
+WorldState::getCell(b2Vec2 position) const
+{
+    const auto cellX = static_cast<int32_t>(std::floor(position.x / cellSize));
+    const auto cellY = static_cast<int32_t>(std::floor(position.y / cellSize));
+    return getCellKey(cellX, cellY);
+}
+
+uint64_t
+WorldState::getCellKey(int32_t cellX, int32_t cellY)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellY);
+}
+
+void
+WorldState::removeFromCell(uint64_t cell, SlotHandle handle)
+{
+    auto it = cells.find(cell);
+    if (it == cells.end()) {
+        return;
+    }
+
+    // The order does not matter, so avoid shifting the rest
+    auto &handles = it->second;
+    auto found = std::find(handles.begin(), handles.end(), handle);
+    if (found != handles.end()) {
+        *found = handles.back();
+        handles.pop_back();
+    }
+}
@@ -0,0 +1,126 @@
+// MIT License
+
+// Copyright (c) 2023 Johan Lind, Ermias Tewolde
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MARSIM_WORLD_STATE_H
+#define MARSIM_WORLD_STATE_H
+
+#include "object.h"
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Streams the objects around the robot on out/world, as changes since the last message:
+//
+//   {"destroyed": [id, ...],
+//    "keyframe": bool,
+//    "moved": {"id": [...], "r": [...], "x": [...], "y": [...]},
+//    "sequence": n,
+//    "spawned": {"id": [...], "r": [...], "type": [...], "x": [...], "y": [...]},
+//    "types": {"Alien": 5, ...}}
+//
+// Clients apply destroyed, then spawned, then moved, since a dropped item can spawn with the id of one destroyed in
+// the same message. Objects that leave the radius are destroyed and spawned again when they come back. A keyframe
+// spawns every object in range, the client drops what it had, and it comes with the types, which map object names to
+// the type ids. Nothing is published while nothing changed.
+//
+// Every other message only applies on top of the one with the previous sequence number, a client that missed one
+// waits for the next keyframe. One follows every message that was thrown away before it left the simulator, and with
+// latestValue on the topic every message is a keyframe, since the queue keeps only the last one.
+class WorldState
+{
+public:
+    // Objects are kept in a grid of square cells. Those within radius of the center are streamed, and move once they
+    // moved minDistance meters or turned minAngle degrees since they were last sent.
+    void configure(float cellSize, float radius, float minDistance, float minAngle, double keyframeInterval);
+
+    // Called when the object starts to be simulated. Robots, their parts and proximity sensors are left out.
+    void add(Object *object);
+
+    // Called when the object stops being simulated
+    void remove(Object *object);
+
+    // Called every step for the objects with awake bodies, which can have moved into another cell
+    void markAwake(Object *object);
+
+    // Publishes what changed around the center, time is the simulated time in seconds
+    void publish(b2Vec2 center, double time);
+
+private:
+    struct Entry
+    {
+        Object *object;
+        unsigned int id;
+        int type;
+        uint64_t cell;
+        b2Vec2 sentPosition{};
+        float sentAngle{};
+        uint32_t lastSeen{0}; // query that last found the object in range
+        bool sent{false};
+        bool awake{false}; // in awakeHandles
+    };
+
+    struct Change
+    {
+        SlotHandle handle;
+        b2Vec2 position;
+        float angle;
+    };
+
+    uint64_t getCell(b2Vec2 position) const;
+
+    static uint64_t getCellKey(int32_t cellX, int32_t cellY);
+
+    void removeFromCell(uint64_t cell, SlotHandle handle);
+
+    float cellSize{16.f};
+    float radius{60.f};
+    float minDistance{0.05f};
+    float minAngle{0.035f}; // radians
+    double keyframeInterval{10.0};
+
+    SlotMap<Entry> entries;
+    std::unordered_map<uint64_t, std::vector<SlotHandle>> cells;
+    std::map<std::string, int> typeIds; // sorted, the same as nlohmann::json writes keys
+
+    // Sent objects that stopped being simulated since the last message
+    std::vector<unsigned int> destroyedIds;
+
+    // Objects marked awake since the last publish
+    std::vector<SlotHandle> awakeHandles;
+
+    // Objects in range at the last publish, which the client has
+    std::vector<SlotHandle> sentHandles;
+
+    uint32_t queries{0};
+    uint32_t sequence{0};
+    double lastKeyframeTime{-1.0};
+    bool keyframeNeeded{true};
+    unsigned int discardedMessages{0};
+
+    // Reused by every publish
+    std::vector<Change> spawned, moved;
+    std::vector<SlotHandle> inRange, left;
+};
+
+#endif // MARSIM_WORLD_STATE_H